@@ -0,0 +1,38 @@
+#pragma once
+// Benchmark helpers: best of several timed runs and a sink keeping results
+// alive.
+//============================================================================
+#include <chrono>
+#include <cstdio>
+
+namespace univang {
+namespace bench {
+
+// Consumes a value so the computation producing it is not optimized out.
+template<class T>
+inline void keep(const T& value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+// Best wall time of runs calls of fn, in nanoseconds.
+template<class F>
+inline double best_of(int runs, F&& fn) {
+    double best = 1e300;
+    for(int r = 0; r < runs; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        double ns = std::chrono::duration<double, std::nano>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+        if(ns < best)
+            best = ns;
+    }
+    return best;
+}
+
+inline void report(const char* name, double ns_per_op) {
+    std::printf("  %-40s %8.2f ns/op\n", name, ns_per_op);
+}
+
+} // namespace bench
+} // namespace univang
@@ -0,0 +1,41 @@
+// Per-element calls against invoke_batch, in cache and memory bound.
+//============================================================================
+#include "bench.hpp"
+
+#include <univang/function.hpp>
+
+#include <vector>
+
+using namespace univang;
+
+int main() {
+    using batch_function =
+        function<float(float), fn_opt::copy_move | fn_opt::batch>;
+    batch_function f = [](float x) { return x * 1.5f + 2.0f; };
+    const size_t n = size_t(1) << 24;
+    const size_t block = 4096;
+    std::vector<float> in(n), out(n);
+    for(size_t i = 0; i < n; ++i)
+        in[i] = static_cast<float>(i) * 0.5f;
+
+    auto per_element = [&](size_t size) {
+        return bench::best_of(5, [&] {
+            for(size_t k = 0; k < n / size; ++k) {
+                for(size_t i = 0; i < size; ++i)
+                    out[i] = f(in[i]);
+            }
+        });
+    };
+    auto batched = [&](size_t size) {
+        return bench::best_of(5, [&] {
+            for(size_t k = 0; k < n / size; ++k)
+                f.invoke_batch(in.data(), out.data(), size);
+        });
+    };
+    std::printf("invoke_batch, float(float):\n");
+    bench::report("4K in cache, per call", per_element(block) / n);
+    bench::report("4K in cache, invoke_batch", batched(block) / n);
+    bench::report("16M, per call", per_element(n) / n);
+    bench::report("16M, invoke_batch", batched(n) / n);
+    bench::keep(out[n - 1]);
+}
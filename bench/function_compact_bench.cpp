@@ -0,0 +1,59 @@
+// Sweep over large tables of functions: footprint against the registry
+// load of compact_function.
+//============================================================================
+#include "bench.hpp"
+
+#include <univang/function_compact.hpp>
+
+#include <random>
+#include <vector>
+
+using namespace univang;
+
+namespace {
+
+constexpr size_t entries = 10000000;
+
+template<class Function>
+void sweep(const char* name, int types) {
+    std::vector<Function> v;
+    v.reserve(entries);
+    std::mt19937 rng(1);
+    for(size_t i = 0; i < entries; ++i) {
+        long a = static_cast<long>(i), b = a * 3, c = a ^ 7;
+        switch(types == 1 ? 0 : rng() % 4) {
+        case 0:
+            v.emplace_back([a, b, c] { return a + b + c; });
+            break;
+        case 1:
+            v.emplace_back([a, b, c] { return a * b - c; });
+            break;
+        case 2:
+            v.emplace_back([a, b, c] { return a ^ b ^ c; });
+            break;
+        default:
+            v.emplace_back([a, b, c] { return a - b + c; });
+            break;
+        }
+    }
+    long sum = 0;
+    double ns = bench::best_of(5, [&] {
+        for(auto& f : v)
+            sum += f();
+    });
+    bench::keep(sum);
+    std::printf("  %-30s %3zu B", name, sizeof(Function));
+    std::printf(" %8.2f ns/call\n", ns / entries);
+}
+
+} // namespace
+
+int main() {
+    std::printf("compact_function, 10M entries, one target type:\n");
+    sweep<function<long()>>("function<long()>", 1);
+    sweep<compact_function<long(), 28>>("compact_function<long(), 28>", 1);
+    sweep<compact_function<long()>>("compact_function<long()>", 1);
+    std::printf("compact_function, 10M entries, four target types:\n");
+    sweep<function<long()>>("function<long()>", 4);
+    sweep<compact_function<long(), 28>>("compact_function<long(), 28>", 4);
+}
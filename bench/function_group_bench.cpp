@@ -0,0 +1,72 @@
+// Event handlers of mixed types: vector of functions against type grouped
+// storage.
+//============================================================================
+#include "bench.hpp"
+
+#include <univang/function_group.hpp>
+
+#include <random>
+#include <vector>
+
+using namespace univang;
+
+namespace {
+
+struct event {
+    long sum = 0;
+};
+
+template<int K>
+struct handler {
+    long v;
+
+    void operator()(event& e) const {
+        e.sum += v * K + K;
+    }
+};
+
+template<class Group>
+double per_call(Group& group, size_t count) {
+    event e;
+    double ns = bench::best_of(5, [&] { group(e); });
+    bench::keep(e.sum);
+    return ns / static_cast<double>(count);
+}
+
+} // namespace
+
+int main() {
+    const size_t count = 1000000;
+    std::mt19937 rng(1);
+    std::vector<function<void(event&)>> functions;
+    function_group<void(event&)> concrete, grouped;
+    for(size_t i = 0; i < count; ++i) {
+        long v = static_cast<long>(i);
+        switch(rng() % 8) {
+#define UNIVANG_BENCH_HANDLER(k)                                             \
+    case k:                                                                  \
+        functions.push_back(handler<k>{v});                                  \
+        concrete.push_back(handler<k>{v});                                   \
+        break;
+            UNIVANG_BENCH_HANDLER(0)
+            UNIVANG_BENCH_HANDLER(1)
+            UNIVANG_BENCH_HANDLER(2)
+            UNIVANG_BENCH_HANDLER(3)
+            UNIVANG_BENCH_HANDLER(4)
+            UNIVANG_BENCH_HANDLER(5)
+            UNIVANG_BENCH_HANDLER(6)
+            UNIVANG_BENCH_HANDLER(7)
+#undef UNIVANG_BENCH_HANDLER
+        }
+    }
+    for(auto& f : functions)
+        grouped.push_back(f);
+    auto sequential = [&functions](event& e) {
+        for(auto& f : functions)
+            f(e);
+    };
+    std::printf("function_group, 1M handlers of 8 types:\n");
+    bench::report("vector<function>", per_call(sequential, count));
+    bench::report("function_group, function values", per_call(grouped, count));
+    bench::report("function_group, concrete", per_call(concrete, count));
+}
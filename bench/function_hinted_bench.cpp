@@ -0,0 +1,61 @@
+// Calls of a dominant target type with and without a type hint.
+//============================================================================
+#include "bench.hpp"
+
+#include <univang/function_hinted.hpp>
+
+#include <random>
+#include <vector>
+
+using namespace univang;
+
+namespace {
+
+struct add {
+    int k;
+
+    int operator()(int x) const {
+        return x + k;
+    }
+};
+
+struct mul {
+    int k;
+
+    int operator()(int x) const {
+        return x * k;
+    }
+};
+
+template<class Vector>
+double per_call(Vector& v) {
+    long sum = 0;
+    double ns = bench::best_of(5, [&] {
+        for(int it = 0; it < 100; ++it) {
+            for(auto& f : v)
+                sum += f(it);
+        }
+    });
+    bench::keep(sum);
+    return ns / (100.0 * static_cast<double>(v.size()));
+}
+
+} // namespace
+
+int main() {
+    std::mt19937 rng(1);
+    std::vector<function<int(int)>> plain;
+    std::vector<hinted_function<function<int(int)>, add>> hinted;
+    for(int i = 0; i < 100000; ++i) {
+        if(rng() % 10 != 0) {
+            plain.push_back(add{i});
+            hinted.push_back(add{i});
+        } else {
+            plain.push_back(mul{i});
+            hinted.push_back(mul{i});
+        }
+    }
+    std::printf("hinted_function, 100K functions, 90%% of one type:\n");
+    bench::report("function", per_call(plain));
+    bench::report("hinted_function", per_call(hinted));
+}
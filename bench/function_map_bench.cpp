@@ -0,0 +1,73 @@
+// Message dispatch by type name: perfect hash and flat maps against
+// std::unordered_map of std::function.
+//============================================================================
+#include "bench.hpp"
+
+#include <univang/function_map.hpp>
+
+#include <functional>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace univang;
+
+namespace {
+
+constexpr std::string_view names[] = {
+    "login", "logout", "ping",      "pong",  "subscribe", "unsubscribe",
+    "data",  "ack",    "nack",      "heartbeat", "order", "cancel",
+    "fill",  "quote",  "trade",     "status"};
+
+constexpr auto keys = make_perfect_hash(names);
+
+} // namespace
+
+int main() {
+    long sink = 0;
+    auto perfect = make_function_map<void(int)>(keys);
+    function_map<std::string_view, void(int)> flat;
+    function_map<std::string, void(int)> flat_string;
+    std::unordered_map<std::string, std::function<void(int)>> unordered;
+    for(size_t i = 0; i < 16; ++i) {
+        auto f = [&sink, i](int v) { sink += v + static_cast<long>(i); };
+        perfect[i] = f;
+        flat.insert_or_assign(names[i], f);
+        flat_string.insert_or_assign(std::string(names[i]), f);
+        unordered[std::string(names[i])] = f;
+    }
+    std::vector<std::string_view> sequence(1 << 16);
+    std::mt19937 rng(1);
+    for(auto& s : sequence)
+        s = names[rng() % 16];
+    std::vector<std::string> strings(sequence.begin(), sequence.end());
+
+    auto per_lookup = [&sequence](auto&& dispatch) {
+        double ns = bench::best_of(5, [&] {
+            for(int rep = 0; rep < 20; ++rep) {
+                for(size_t i = 0; i < sequence.size(); ++i)
+                    dispatch(i);
+            }
+        });
+        return ns / (20.0 * static_cast<double>(sequence.size()));
+    };
+    std::printf("function_map, 16 keys, lookup and call:\n");
+    bench::report(
+        "static_function_map", per_lookup([&](size_t i) {
+            (*perfect.find(sequence[i]))(1);
+        }));
+    bench::report(
+        "function_map<string_view>", per_lookup([&](size_t i) {
+            (*flat.find(sequence[i]))(1);
+        }));
+    bench::report(
+        "function_map<string>, string_view key", per_lookup([&](size_t i) {
+            (*flat_string.find(sequence[i]))(1);
+        }));
+    bench::report(
+        "unordered_map<string, std::function>", per_lookup([&](size_t i) {
+            unordered.find(strings[i])->second(1);
+        }));
+    bench::keep(sink);
+}
@@ -0,0 +1,43 @@
+// Calls after initialization: once_function_mt and lazy against
+// std::call_once.
+//============================================================================
+#include "bench.hpp"
+
+#include <univang/function_once.hpp>
+
+#include <mutex>
+
+using namespace univang;
+
+int main() {
+    const int calls = 10000000;
+    once_function_mt<int()> once = [] { return 42; };
+    lazy<long> value([] { return 7L; });
+    std::once_flag flag;
+    int initialized = 0;
+
+    once();
+    value.get();
+    std::call_once(flag, [&initialized] { initialized = 42; });
+
+    long sum = 0;
+    std::printf("once_function_mt, done path:\n");
+    bench::report(
+        "once_function_mt()", bench::best_of(5, [&] {
+            for(int i = 0; i < calls; ++i)
+                sum += once();
+        }) / calls);
+    bench::report(
+        "lazy<long>::get()", bench::best_of(5, [&] {
+            for(int i = 0; i < calls; ++i)
+                sum += value.get();
+        }) / calls);
+    bench::report(
+        "std::call_once", bench::best_of(5, [&] {
+            for(int i = 0; i < calls; ++i) {
+                std::call_once(flag, [&initialized] { initialized = 42; });
+                sum += initialized;
+            }
+        }) / calls);
+    bench::keep(sum);
+}
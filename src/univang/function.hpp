@@ -1,7 +1,51 @@
 #pragma once
 // std::function-like callable wrappers.
 //============================================================================
+#include <atomic>
+#include <cstddef>
+#include <cstring>
 #include <functional>
+#include <memory>
+#include <stdexcept>
+#if __cplusplus >= 202002L && defined(__has_include)
+#if __has_include(<span>)
+#include <span>
+#endif
+#endif
+#if defined(UNIVANG_FUNCTION_STATS)
+#include "function_stats.hpp"
+#endif
+
+// Opt-in clang trivial ABI (UNIVANG_FUNCTION_TRIVIAL_ABI): functions are
+// passed in registers. The attribute requires memcpy relocation, so every
+// function becomes relocatable, with two effects:
+//  - targets that are not trivially relocatable (e.g. capturing a
+//    std::string) are allocated instead of stored locally;
+//  - fs_function, which cannot allocate, rejects such targets at compile
+//    time.
+// Functions without copy and move (fn_opt::none) keep the regular ABI:
+// clang ignores the attribute on classes that can be neither copied nor
+// moved.
+#if defined(UNIVANG_FUNCTION_TRIVIAL_ABI) && defined(__has_cpp_attribute)
+#if __has_cpp_attribute(clang::trivial_abi)
+#define UNIVANG_TRIVIAL_ABI [[clang::trivial_abi]]
+#define UNIVANG_HAS_TRIVIAL_ABI 1
+#endif
+#endif
+#ifndef UNIVANG_TRIVIAL_ABI
+#define UNIVANG_TRIVIAL_ABI
+#define UNIVANG_HAS_TRIVIAL_ABI 0
+#endif
+
+// Constant construction of stateless and function pointer targets (C++20).
+#if defined(__cpp_constexpr) && __cpp_constexpr >= 201907L && \
+    defined(__cpp_lib_is_constant_evaluated)
+#define UNIVANG_FUNCTION_CONSTEXPR constexpr
+#define UNIVANG_HAS_FUNCTION_CONSTEXPR 1
+#else
+#define UNIVANG_FUNCTION_CONSTEXPR
+#define UNIVANG_HAS_FUNCTION_CONSTEXPR 0
+#endif
 
 namespace univang {
 
@@ -12,6 +56,9 @@ enum class fn_opt {
     move = 2,
     no_alloc = 4,
     once = 8 + 2, // +2 to ensure movable
+    relocatable = 16, // inline only trivially relocatable targets
+    batch = 32, // invoke_batch() for R(Arg) signatures
+    comparable = 64, // operator== and std::hash by target value
     // Option combo's.
     copy_move = 3
 };
@@ -23,15 +70,94 @@ inline constexpr fn_opt operator&(fn_opt lhs, fn_opt rhs) {
     return fn_opt(static_cast<int>(lhs) & static_cast<int>(rhs));
 }
 
-template<class F, size_t Size, fn_opt Options>
+// Storage policies: target placement and dynamic storage scheme.
+//   allow_local   - target may be kept in local storage (Size bytes).
+//   allow_dynamic - target may be placed out of the function object.
+//   relocatable   - local targets moved by memcpy, see fn_opt::relocatable.
+//   allocator     - dynamic storage allocator, default constructed per
+//                   target (void - new/delete).
+//   alignment     - local storage alignment (0 - default for Size).
+//   object_alignment - minimal function object alignment (0 - natural).
+//============================================================================
+struct fn_default_storage {
+    constexpr static bool allow_local = true;
+    constexpr static bool allow_dynamic = true;
+    constexpr static bool relocatable = false;
+    constexpr static size_t alignment = 0;
+    constexpr static size_t object_alignment = 0;
+    using allocator = void;
+};
+
+// Local storage with explicit alignment.
+template<size_t Align>
+struct fn_aligned_storage : fn_default_storage {
+    constexpr static size_t alignment = Align;
+};
+
+// Local storage only (same as fn_opt::no_alloc).
+struct fn_inline_storage : fn_default_storage {
+    constexpr static bool allow_dynamic = false;
+};
+
+// Always dynamic storage.
+struct fn_heap_storage : fn_default_storage {
+    constexpr static bool allow_local = false;
+};
+
+// Reference counted heap target shared by function copies (the target
+// itself need not be copyable).
+struct fn_shared_alloc {};
+
+struct fn_shared_storage : fn_default_storage {
+    constexpr static bool allow_local = false;
+    using allocator = fn_shared_alloc;
+};
+
+template<
+    class F, size_t Size, fn_opt Options, class Storage = fn_default_storage>
 class basic_function;
 
+// Type can be moved to another address by memcpy without running its move
+// constructor and destructor. Specialize for own types when applicable.
+template<class T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+template<class T>
+struct is_trivially_relocatable<std::unique_ptr<T>> : std::true_type {};
+
+template<class T>
+struct is_trivially_relocatable<std::shared_ptr<T>> : std::true_type {};
+
+template<class T>
+struct is_trivially_relocatable<std::weak_ptr<T>> : std::true_type {};
+
+// C style callback: fn(context, args...), e.g. as taken by C libraries.
+template<class R, class... Args>
+struct fn_c_callback {
+    using function_type = R (*)(void*, Args...);
+
+    function_type fn;
+    void* context;
+
+    R operator()(Args... args) const {
+        return fn(context, static_cast<Args&&>(args)...);
+    }
+};
+
 namespace detail {
 namespace function {
 
 // Default small-optimize size.
 constexpr static size_t default_size = sizeof(void*) * 4;
 
+// Function object header: invoke_ and manage_ pointers.
+constexpr static size_t header_size = sizeof(void*) * 2;
+
+constexpr static size_t cache_line_size = 64;
+
+// All functions are relocatable under trivial ABI.
+constexpr static bool trivial_abi = UNIVANG_HAS_TRIVIAL_ABI != 0;
+
 // Optional specialization helpers.
 //============================================================================
 inline constexpr bool fn_opt_enabled(fn_opt mask, fn_opt opt) {
@@ -49,6 +175,123 @@ template<fn_opt Options>
 using enable_if_not_once =
     typename std::enable_if<(Options & fn_opt::once) != fn_opt::once>::type;
 
+// Index of T in Ts, sizeof...(Ts) if absent.
+template<class T, class... Ts>
+struct type_index;
+
+template<class T>
+struct type_index<T> : std::integral_constant<size_t, 0> {};
+
+template<class T, class... Ts>
+struct type_index<T, T, Ts...> : std::integral_constant<size_t, 0> {};
+
+template<class T, class U, class... Ts>
+struct type_index<T, U, Ts...>
+    : std::integral_constant<size_t, 1 + type_index<T, Ts...>::value> {};
+
+// Base deleting copy operations of otherwise copyable wrappers.
+template<bool Copyable>
+struct copy_control {};
+
+template<>
+struct copy_control<false> {
+    copy_control() = default;
+    copy_control(const copy_control&) = delete;
+    copy_control& operator=(const copy_control&) = delete;
+    copy_control(copy_control&&) = default;
+    copy_control& operator=(copy_control&&) = default;
+};
+
+// Instrumentation hooks, keyed by manager (see function_stats.hpp).
+//============================================================================
+#if defined(UNIVANG_FUNCTION_STATS)
+using stats_hooks = stats_recorder;
+#else
+struct stats_hooks {
+    template<class F>
+    static void construct(const void* /*key*/, bool /*local*/) {
+    }
+    template<class Owner>
+    static void store(size_t /*capacity*/, size_t /*size*/, bool /*movable*/) {
+    }
+    static void copy(const void* /*key*/) {
+    }
+    static void move(const void* /*key*/) {
+    }
+    static void call(const void* /*key*/) {
+    }
+};
+#endif
+
+template<class Fn>
+inline const void* stats_key(Fn fn) noexcept {
+    return reinterpret_cast<const void*>(fn);
+}
+
+inline constexpr bool constant_evaluated() noexcept {
+#if UNIVANG_HAS_FUNCTION_CONSTEXPR
+    return std::is_constant_evaluated();
+#else
+    return false;
+#endif
+}
+
+// Target without state: nothing is stored, the trampoline creates it.
+template<class F>
+struct is_stateless
+    : std::integral_constant<
+          bool,
+          std::is_empty<F>::value &&
+              std::is_trivially_default_constructible<F>::value &&
+              std::is_trivially_copyable<F>::value> {};
+
+// Local target access.
+template<class F, bool IsConst, bool Stateless = is_stateless<F>::value>
+struct fn_local_target {
+    using type = typename std::conditional<IsConst, const F, F>::type;
+
+    static type& get(void* f) noexcept {
+        return *static_cast<type*>(f);
+    }
+};
+
+template<class F, bool IsConst>
+struct fn_local_target<F, IsConst, true> {
+    using type = typename std::conditional<IsConst, const F, F>::type;
+
+    static type get(void* /*f*/) noexcept {
+        return type();
+    }
+};
+
+// Owning pointers (e.g. unique_ptr to a base with virtual operator()) are
+// adopted as targets: the pointer is stored and called through, so the
+// call is the trampoline plus the pointee call.
+template<class P>
+struct is_owning_pointer : std::false_type {};
+
+template<class T, class D>
+struct is_owning_pointer<std::unique_ptr<T, D>> : std::true_type {};
+
+template<class T>
+struct is_owning_pointer<std::shared_ptr<T>> : std::true_type {};
+
+template<class P>
+struct fn_adopted {
+    P ptr;
+
+    template<class... A>
+    auto operator()(A&&... args) const
+        -> decltype((*ptr)(std::forward<A>(args)...)) {
+        return (*ptr)(std::forward<A>(args)...);
+    }
+
+    // Same pointee (fn_opt::comparable).
+    bool operator==(const fn_adopted& rhs) const noexcept {
+        return ptr == rhs.ptr;
+    }
+};
+
 // Function invocation helper.
 //============================================================================
 template<class F, bool Local, bool IsConst, class R, class... Args>
@@ -58,8 +301,8 @@ struct fn_handler;
 template<class F, bool IsConst, class R, class... Args>
 struct fn_handler<F, true, IsConst, R, Args...> {
     static R invoke(void* f, Args... args) {
-        using Fp = typename std::conditional<IsConst, const F*, F*>::type;
-        return (*static_cast<Fp>(f))(static_cast<Args&&>(args)...);
+        auto&& target = fn_local_target<F, IsConst>::get(f);
+        return target(static_cast<Args&&>(args)...);
     }
 };
 
@@ -72,15 +315,187 @@ struct fn_handler<F, false, IsConst, R, Args...> {
     }
 };
 
+// Batch invocation helper: the loop runs in target typed code, so the
+// target can be inlined (and vectorized) into it.
+template<class F, bool Local, bool IsConst, class R, class Arg>
+struct fn_batch_handler {
+    using input_type = typename std::decay<Arg>::type;
+
+    static void invoke_batch(
+        void* f, const input_type* in, R* out, size_t count) {
+        invoke_batch(f, in, out, count, std::integral_constant<bool, Local>());
+    }
+
+    static void invoke_batch(
+        void* f, const input_type* in, R* out, size_t count,
+        std::true_type /*local*/) {
+        auto&& target = fn_local_target<F, IsConst>::get(f);
+        for(size_t i = 0; i < count; ++i)
+            out[i] = target(in[i]);
+    }
+
+    static void invoke_batch(
+        void* f, const input_type* in, R* out, size_t count,
+        std::false_type /*local*/) {
+        using Fp = typename std::conditional<IsConst, const F*, F*>::type;
+        Fp fn = *static_cast<Fp*>(f);
+        for(size_t i = 0; i < count; ++i)
+            out[i] = (*fn)(in[i]);
+    }
+};
+
 // Function operation (destruct/copy/move etc.).
 //============================================================================
 enum class exec_op {
     DESTRUCT,
     MOVE,
     COPY,
+    MIGRATE, // re-place dynamic target as its allocator suggests
+    EQUAL, // compare with target of the same manager (dst is fn_compare)
+    HASH, // target hash (dst is size_t)
+};
+
+// Target comparison (fn_opt::comparable).
+//============================================================================
+struct fn_compare {
+    void* rhs; // storage of the other target
+    bool equal;
+};
+
+template<class F, class Enable = void>
+struct has_target_equal : std::false_type {};
+
+template<class F>
+struct has_target_equal<
+    F,
+    typename std::enable_if<std::is_convertible<
+        decltype(std::declval<const F&>() == std::declval<const F&>()),
+        bool>::value>::type> : std::true_type {};
+
+template<class F, class Enable = void>
+struct has_target_hash : std::false_type {};
+
+template<class F>
+struct has_target_hash<
+    F,
+    typename std::enable_if<std::is_convertible<
+        decltype(std::hash<F>()(std::declval<const F&>())),
+        size_t>::value>::type> : std::true_type {};
+
+// Trivially copyable targets whose value is their bytes: no padding, no
+// floating point or reference members (capture a pointer instead of a
+// reference). Requires C++17 std::has_unique_object_representations.
+#if defined(__cpp_lib_has_unique_object_representations)
+template<class F>
+struct is_bytewise_comparable
+    : std::integral_constant<
+          bool,
+          std::is_trivially_copyable<F>::value &&
+              std::has_unique_object_representations<F>::value> {};
+#else
+template<class F>
+struct is_bytewise_comparable : std::false_type {};
+#endif
+
+// Stateless targets are all equal, targets with operator== use it (and
+// std::hash<F> when provided), other targets compare bytewise when their
+// bytes are their value.
+template<class F>
+struct is_comparable_target
+    : std::integral_constant<
+          bool,
+          is_stateless<F>::value || has_target_equal<F>::value ||
+              is_bytewise_comparable<F>::value> {};
+
+// Scalar targets (function pointers) whose bytes are their value: their
+// operator== compares exactly those bytes, so they hash by them too.
+template<class F>
+struct is_bytewise_hashed
+    : std::integral_constant<
+          bool,
+          std::is_scalar<F>::value && is_bytewise_comparable<F>::value> {};
+
+template<class F>
+struct fn_target_compare {
+    using equal_kind = std::integral_constant<
+        int,
+        is_stateless<F>::value          ? 0
+            : has_target_equal<F>::value ? 1
+                                         : 2>;
+    using hash_kind = std::integral_constant<
+        int,
+        is_stateless<F>::value            ? 0
+            : has_target_hash<F>::value    ? 1
+            : is_bytewise_hashed<F>::value ? 2
+            : has_target_equal<F>::value   ? 0
+                                           : 2>;
+
+    static bool equal(const F* lhs, const F* rhs) {
+        return equal(lhs, rhs, equal_kind());
+    }
+    static bool equal(
+        const F* /*lhs*/, const F* /*rhs*/, std::integral_constant<int, 0>) {
+        return true;
+    }
+    static bool equal(
+        const F* lhs, const F* rhs, std::integral_constant<int, 1>) {
+        return *lhs == *rhs;
+    }
+    static bool equal(
+        const F* lhs, const F* rhs, std::integral_constant<int, 2>) {
+        return std::memcmp(lhs, rhs, sizeof(F)) == 0;
+    }
+
+    // Targets equal by operator== but without std::hash<F> fall back to the
+    // manager-only hash: all of them (per target type) share one bucket, so
+    // provide std::hash<F> for targets meant for unordered containers.
+    static size_t hash(const F* f) {
+        return hash(f, hash_kind());
+    }
+    static size_t hash(const F* /*f*/, std::integral_constant<int, 0>) {
+        return 0;
+    }
+    static size_t hash(const F* f, std::integral_constant<int, 1>) {
+        return std::hash<F>()(*f);
+    }
+    static size_t hash(const F* f, std::integral_constant<int, 2>) {
+        // FNV-1a.
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(f);
+        size_t h = sizeof(size_t) == 8 ? size_t(14695981039346656037ull)
+                                       : size_t(2166136261u);
+        const size_t prime =
+            sizeof(size_t) == 8 ? size_t(1099511628211ull) : size_t(16777619u);
+        for(size_t i = 0; i < sizeof(F); ++i)
+            h = (h ^ p[i]) * prime;
+        return h;
+    }
+};
+
+// Manager adding EQUAL/HASH to Manager of target F.
+template<class F, class Manager>
+struct fn_compare_manager {
+    static void manage(exec_op op, void* src, void* dst) {
+        switch(op) {
+        case exec_op::EQUAL: {
+            fn_compare* args = static_cast<fn_compare*>(dst);
+            args->equal = fn_target_compare<F>::equal(
+                Manager::target(src), Manager::target(args->rhs));
+            break;
+        }
+        case exec_op::HASH:
+            *static_cast<size_t*>(dst) =
+                fn_target_compare<F>::hash(Manager::target(src));
+            break;
+        default:
+            Manager::manage(op, src, dst);
+            break;
+        }
+    }
 };
 
-template<class F, bool LocalStorage, bool Movable, bool Copyable>
+template<
+    class F, bool LocalStorage, bool Movable, bool Copyable,
+    class Alloc = void>
 struct fn_manager;
 
 // Local storage.
@@ -97,6 +512,9 @@ struct fn_manager<F, true, Movable, Copyable> {
     }
     static void copy(void* /*src*/, void* /*dst*/, std::false_type /*tag*/) {
     }
+    static F* target(void* src) noexcept {
+        return static_cast<F*>(src);
+    }
     static void manage(exec_op op, void* src, void* dst) {
         switch(op) {
         case exec_op::DESTRUCT:
@@ -108,6 +526,10 @@ struct fn_manager<F, true, Movable, Copyable> {
         case exec_op::COPY:
             copy(src, dst, std::integral_constant<bool, Copyable>());
             break;
+        case exec_op::MIGRATE:
+        case exec_op::EQUAL:
+        case exec_op::HASH:
+            break;
         }
     }
 };
@@ -130,6 +552,9 @@ struct fn_manager<F, false, Movable, Copyable> {
     }
     static void copy(void* /*src*/, void* /*dst*/, std::false_type /*tag*/) {
     }
+    static F* target(void* src) noexcept {
+        return *static_cast<F**>(src);
+    }
     static void manage(exec_op op, void* src, void* dst) {
         switch(op) {
         case exec_op::DESTRUCT:
@@ -141,21 +566,287 @@ struct fn_manager<F, false, Movable, Copyable> {
         case exec_op::COPY:
             copy(src, dst, std::integral_constant<bool, Copyable>());
             break;
+        case exec_op::MIGRATE:
+        case exec_op::EQUAL:
+        case exec_op::HASH:
+            break;
+        }
+    }
+};
+
+// Allocator suggesting better placement for existing targets.
+template<class Alloc, class Enable = void>
+struct has_migration_target : std::false_type {};
+
+template<class Alloc>
+struct has_migration_target<
+    Alloc,
+    typename std::enable_if<std::is_same<
+        decltype(std::declval<const Alloc&>().migration_target()),
+        Alloc>::value>::type> : std::true_type {};
+
+// Dynamic storage with allocator: target pointer followed by allocator
+// state (omitted for stateless allocators).
+template<class F, class Alloc, bool Stateless = std::is_empty<Alloc>::value>
+struct alloc_slot {
+    F* fn;
+    Alloc alloc;
+
+    Alloc get_allocator() const noexcept {
+        return alloc;
+    }
+};
+
+template<class F, class Alloc>
+struct alloc_slot<F, Alloc, true> {
+    F* fn;
+
+    alloc_slot(F* f, const Alloc& /*alloc*/) noexcept : fn(f) {
+    }
+
+    Alloc get_allocator() const noexcept {
+        return Alloc();
+    }
+};
+
+template<class F, bool Movable, bool Copyable, class Alloc>
+struct fn_manager<F, false, Movable, Copyable, Alloc> {
+    using slot = alloc_slot<F, Alloc>;
+
+    template<class... A>
+    static void create(void* dst, const Alloc& alloc, A&&... args) {
+        Alloc a(alloc);
+        void* p = a.allocate(sizeof(F), alignof(F));
+        try {
+            ::new(p) F(std::forward<A>(args)...);
+        } catch(...) {
+            a.deallocate(p, sizeof(F), alignof(F));
+            throw;
+        }
+        ::new(dst) slot{static_cast<F*>(p), a};
+    }
+    static void move(void* src, void* dst, std::true_type /*tag*/) {
+        slot* src_slot = static_cast<slot*>(src);
+        ::new(dst) slot(std::move(*src_slot));
+        src_slot->~slot();
+    }
+    static void move(void* /*src*/, void* /*dst*/, std::false_type /*tag*/) {
+    }
+    static void copy(void* src, void* dst, std::true_type /*tag*/) {
+        const slot* src_slot = static_cast<const slot*>(src);
+        create(dst, src_slot->get_allocator(), *src_slot->fn);
+    }
+    static void copy(void* /*src*/, void* /*dst*/, std::false_type /*tag*/) {
+    }
+    // Move target to memory of alloc.migration_target() if it differs.
+    static void migrate(void* src, std::true_type /*tag*/) {
+        slot* src_slot = static_cast<slot*>(src);
+        Alloc a = src_slot->get_allocator();
+        Alloc target = a.migration_target();
+        if(target == a)
+            return;
+        F* old_fn = src_slot->fn;
+        typename std::aligned_storage<sizeof(slot), alignof(slot)>::type tmp;
+        create(&tmp, target, std::move_if_noexcept(*old_fn));
+        src_slot->~slot();
+        move(&tmp, src, std::true_type());
+        old_fn->~F();
+        a.deallocate(old_fn, sizeof(F), alignof(F));
+    }
+    static void migrate(void* /*src*/, std::false_type /*tag*/) {
+    }
+    static F* target(void* src) noexcept {
+        return static_cast<slot*>(src)->fn;
+    }
+    static void manage(exec_op op, void* src, void* dst) {
+        switch(op) {
+        case exec_op::DESTRUCT: {
+            slot* src_slot = static_cast<slot*>(src);
+            Alloc a = src_slot->get_allocator();
+            src_slot->fn->~F();
+            a.deallocate(src_slot->fn, sizeof(F), alignof(F));
+            src_slot->~slot();
+            break;
+        }
+        case exec_op::MOVE:
+            move(src, dst, std::integral_constant<bool, Movable>());
+            break;
+        case exec_op::COPY:
+            copy(src, dst, std::integral_constant<bool, Copyable>());
+            break;
+        case exec_op::MIGRATE:
+            migrate(src, has_migration_target<Alloc>());
+            break;
+        case exec_op::EQUAL:
+        case exec_op::HASH:
+            break;
         }
     }
 };
 
+// Shared dynamic storage: target pointer and its reference counted block.
+template<class F>
+struct shared_block {
+    std::atomic<size_t> refs;
+    F fn;
+
+    template<class... A>
+    explicit shared_block(A&&... args)
+        : refs(1), fn(std::forward<A>(args)...) {
+    }
+};
+
+template<class F>
+struct shared_slot {
+    F* fn;
+    shared_block<F>* block;
+};
+
+template<class F, bool Movable, bool Copyable>
+struct fn_manager<F, false, Movable, Copyable, fn_shared_alloc> {
+    using slot = shared_slot<F>;
+
+    template<class... A>
+    static void create(
+        void* dst, const fn_shared_alloc& /*alloc*/, A&&... args) {
+        auto* block = new shared_block<F>(std::forward<A>(args)...);
+        ::new(dst) slot{&block->fn, block};
+    }
+    static void copy(void* src, void* dst, std::true_type /*tag*/) {
+        const slot* src_slot = static_cast<const slot*>(src);
+        src_slot->block->refs.fetch_add(1, std::memory_order_relaxed);
+        ::new(dst) slot(*src_slot);
+    }
+    static void copy(void* /*src*/, void* /*dst*/, std::false_type /*tag*/) {
+    }
+    static F* target(void* src) noexcept {
+        return static_cast<slot*>(src)->fn;
+    }
+    static void manage(exec_op op, void* src, void* dst) {
+        switch(op) {
+        case exec_op::DESTRUCT: {
+            shared_block<F>* block = static_cast<slot*>(src)->block;
+            if(block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                delete block;
+            break;
+        }
+        case exec_op::MOVE:
+            if(Movable)
+                ::new(dst) slot(*static_cast<slot*>(src));
+            break;
+        case exec_op::COPY:
+            copy(src, dst, std::integral_constant<bool, Copyable>());
+            break;
+        case exec_op::MIGRATE:
+        case exec_op::EQUAL:
+        case exec_op::HASH:
+            break;
+        }
+    }
+};
+
+// Local storage of Size bytes aligned as the storage policy requests.
+template<size_t Size, class Storage>
+using local_storage = typename std::conditional<
+    Storage::alignment == 0, typename std::aligned_storage<Size>::type,
+    typename std::aligned_storage<Size, Storage::alignment>::type>::type;
+
+// Relocatable by option or storage policy.
+template<fn_opt Options, class Storage>
+inline constexpr bool relocatable_enabled() {
+    return fn_opt_enabled(Options, fn_opt::relocatable) ||
+        Storage::relocatable || trivial_abi;
+}
+
+// Function object alignment, at least the natural one of the header.
+template<class Storage>
+inline constexpr size_t object_alignment() {
+    return Storage::object_alignment > alignof(void*)
+        ? Storage::object_alignment
+        : alignof(void*);
+}
+
+template<fn_opt Options, class Storage>
+inline constexpr bool no_alloc_enabled() {
+    return fn_opt_enabled(Options, fn_opt::no_alloc) ||
+        !Storage::allow_dynamic;
+}
+
+// Batch entry point, stored only with fn_opt::batch.
+template<bool Enabled, bool IsConst, class R, class... Args>
+struct function_batch {
+    template<class F, bool Local>
+    UNIVANG_FUNCTION_CONSTEXPR void set_batch_() noexcept {
+    }
+    template<class Batch>
+    void copy_batch_(const Batch& /*rhs*/) noexcept {
+    }
+    void reset_batch_() noexcept {
+    }
+};
+
+template<bool IsConst, class R, class Arg>
+struct function_batch<true, IsConst, R, Arg> {
+    static_assert(
+        !std::is_void<R>::value && !std::is_reference<R>::value,
+        "batch requires result by value");
+
+    using input_type = typename std::decay<Arg>::type;
+    using batch_fn = void (*)(void*, const input_type*, R*, size_t);
+
+    constexpr function_batch() noexcept : invoke_batch_(&bad_batch_) {
+    }
+
+    template<class F, bool Local>
+    UNIVANG_FUNCTION_CONSTEXPR void set_batch_() noexcept {
+        invoke_batch_ =
+            &fn_batch_handler<F, Local, IsConst, R, Arg>::invoke_batch;
+    }
+    template<class Batch>
+    void copy_batch_(const Batch& rhs) noexcept {
+        invoke_batch_ = rhs.invoke_batch_;
+    }
+    void reset_batch_() noexcept {
+        invoke_batch_ = &bad_batch_;
+    }
+
+    batch_fn invoke_batch_;
+
+    static void bad_batch_(
+        void* /*f*/, const input_type* /*in*/, R* /*out*/, size_t count) {
+        if(count != 0)
+            throw std::bad_function_call();
+    }
+};
+
 // Most base function class.
 //============================================================================
-template<size_t Size, fn_opt Options, bool IsConst, class R, class... Args>
-class function_data {
+template<
+    size_t Size, fn_opt Options, class Storage, bool IsConst, class R,
+    class... Args>
+class UNIVANG_TRIVIAL_ABI alignas(object_alignment<Storage>()) function_data
+    : protected function_batch<
+          fn_opt_enabled(Options, fn_opt::batch), IsConst, R, Args...> {
 public:
     constexpr static bool is_const = IsConst;
     constexpr static bool is_copyable = fn_opt_enabled(Options, fn_opt::copy);
     constexpr static bool is_movable = fn_opt_enabled(Options, fn_opt::move);
-    constexpr static bool no_alloc = fn_opt_enabled(Options, fn_opt::no_alloc);
+    constexpr static bool no_alloc = no_alloc_enabled<Options, Storage>();
+    constexpr static bool is_relocatable =
+        relocatable_enabled<Options, Storage>();
+    constexpr static bool is_comparable =
+        fn_opt_enabled(Options, fn_opt::comparable);
+
+    static_assert(
+        Storage::allow_local || !no_alloc, "storage policy allows no storage");
+    static_assert(
+        !fn_opt_enabled(Options, fn_opt::batch) ||
+            (sizeof...(Args) == 1 && !fn_opt_enabled(Options, fn_opt::once)),
+        "batch requires R(Arg) signature and no call-once");
 
     using result_type = R;
+    // Batch output element (batch results are values, see function_batch).
+    using batch_result_type = typename std::remove_reference<R>::type;
 
     constexpr function_data() noexcept
         : invoke_(&bad_call_), manage_(nullptr), data_null_state_() {
@@ -165,12 +856,15 @@ public:
         : invoke_(rhs.invoke_), manage_(rhs.manage_) {
         if(manage_ == nullptr)
             return;
-        rhs.manage_(exec_op::MOVE, &rhs.data_, &data_);
+        this->copy_batch_(rhs.batch_());
+        stats_hooks::move(stats_key(manage_));
+        move_data_(rhs);
         rhs.default_construct_();
     }
 
-    ~function_data() {
-        if(manage_ != nullptr)
+    // Constant targets need no destruction (constexpr functions).
+    UNIVANG_FUNCTION_CONSTEXPR ~function_data() {
+        if(!constant_evaluated() && manage_ != nullptr)
             manage_(exec_op::DESTRUCT, &data_, nullptr);
     }
 
@@ -179,15 +873,31 @@ public:
     }
 
 protected:
-    using storage_type = typename std::aligned_storage<Size>::type;
+    template<size_t, fn_opt, class, bool, class, class...>
+    friend class function_data;
+
+    using batch_base = function_batch<
+        fn_opt_enabled(Options, fn_opt::batch), IsConst, R, Args...>;
+
+    const batch_base& batch_() const noexcept {
+        return *this;
+    }
+
+    using storage_type = local_storage<Size, Storage>;
     using call_fn = R (*)(void*, Args...);
     using exec_fn = void (*)(exec_op, void*, void*);
 
+    // Function pointer member, for constant construction only.
+    using pointer_type = typename std::conditional<
+        sizeof(R(*)(Args...)) <= sizeof(storage_type), R (*)(Args...),
+        char>::type;
+
     call_fn invoke_;
     exec_fn manage_;
     union {
         char data_null_state_;
         storage_type data_;
+        pointer_type data_pointer_;
     };
 
     void* get_data_() const noexcept {
@@ -198,51 +908,244 @@ protected:
         throw std::bad_function_call();
     }
 
-    // Construct local.
+    // Manager of target F, with EQUAL/HASH for comparable functions.
+    template<class F, class Manager>
+    using manager_ = typename std::conditional<
+        is_comparable, fn_compare_manager<F, Manager>, Manager>::type;
+
+    // Same target type, placement and value (fn_opt::comparable).
+    bool equal_(const function_data& rhs) const {
+        if(manage_ != rhs.manage_)
+            return false;
+        if(manage_ == nullptr)
+            return true;
+        fn_compare args{rhs.get_data_(), false};
+        manage_(exec_op::EQUAL, get_data_(), &args);
+        return args.equal;
+    }
+
+    size_t hash_() const {
+        if(manage_ == nullptr)
+            return 0;
+        size_t h = 0;
+        manage_(exec_op::HASH, get_data_(), &h);
+        size_t key = std::hash<const void*>()(stats_key(manage_));
+        return key ^ (h + 0x9e3779b9 + (key << 6) + (key >> 2));
+    }
+
+    using c_callback_type = fn_c_callback<R, Args...>;
+
+    // Trampoline and storage: invoke_ has the C callback shape. Adopted
+    // callbacks are returned as they are.
+    c_callback_type c_callback_() const noexcept {
+        static_assert(
+            !fn_opt_enabled(Options, fn_opt::once),
+            "call-once function has no C callback");
+        using adopted = fn_handler<c_callback_type, true, IsConst, R, Args...>;
+        if(manage_ == nullptr)
+            return c_callback_type{nullptr, nullptr};
+        if(invoke_ == &adopted::invoke)
+            return *static_cast<const c_callback_type*>(get_data_());
+        return c_callback_type{invoke_, get_data_()};
+    }
+
+    template<class In, class Out>
+    void call_batch_(const In* in, Out* out, size_t count) {
+        this->invoke_batch_(get_data_(), in, out, count);
+    }
+
+    // Local target store: constant for stateless targets (nothing stored)
+    // and plain function pointers.
+    template<class F>
+    using store_kind = std::integral_constant<
+        int,
+        is_stateless<F>::value                      ? 1
+            : std::is_same<F, pointer_type>::value ? 2
+                                                   : 0>;
+
     template<class F>
-    void construct_(F&& f, std::true_type /*tag*/) {
+    void store_local_(F&& f, std::integral_constant<int, 0> /*kind*/) {
         using functor_type = typename std::decay<F>::type;
         new(&data_) functor_type(std::forward<F>(f));
+    }
+
+    template<class F>
+    UNIVANG_FUNCTION_CONSTEXPR void store_local_(
+        F&& /*f*/, std::integral_constant<int, 1> /*kind*/) noexcept {
+    }
+
+    template<class F>
+    UNIVANG_FUNCTION_CONSTEXPR void store_local_(
+        F&& f, std::integral_constant<int, 2> /*kind*/) noexcept {
+        data_pointer_ = f;
+    }
+
+    // Construct local.
+    template<class F>
+    UNIVANG_FUNCTION_CONSTEXPR void construct_(F&& f, std::true_type /*tag*/) {
+        using functor_type = typename std::decay<F>::type;
+        store_local_(std::forward<F>(f), store_kind<functor_type>());
         using handle = fn_handler<functor_type, true, is_const, R, Args...>;
         using manage = fn_manager<functor_type, true, is_movable, is_copyable>;
-        manage_ = &manage::manage;
+        manage_ = &manager_<functor_type, manage>::manage;
         invoke_ = &handle::invoke;
+        this->template set_batch_<functor_type, true>();
+        if(!constant_evaluated())
+            stats_hooks::construct<functor_type>(stats_key(manage_), true);
     }
 
     // Construct dynamic.
     template<class F>
     void construct_(F&& f, std::false_type /*tag*/) {
         using functor_type = typename std::decay<F>::type;
+        static_assert(
+            sizeof(functor_type*) <= sizeof(storage_type),
+            "insufficient storage size");
         *(functor_type**)(&data_) = new functor_type(std::forward<F>(f));
         using handle = fn_handler<functor_type, false, is_const, R, Args...>;
         using manage = fn_manager<functor_type, false, is_movable, is_copyable>;
-        manage_ = &manage::manage;
+        manage_ = &manager_<functor_type, manage>::manage;
         invoke_ = &handle::invoke;
+        this->template set_batch_<functor_type, false>();
+        stats_hooks::construct<functor_type>(stats_key(manage_), false);
     }
 
+    // Construct local, allocator is not used.
+    template<class F, class Alloc>
+    UNIVANG_FUNCTION_CONSTEXPR void construct_(
+        F&& f, const Alloc& /*alloc*/, std::true_type tag) {
+        construct_(std::forward<F>(f), tag);
+    }
+
+    // Construct dynamic with allocator.
+    template<class F, class Alloc>
+    void construct_(F&& f, const Alloc& alloc, std::false_type /*tag*/) {
+        using functor_type = typename std::decay<F>::type;
+        using manage =
+            fn_manager<functor_type, false, is_movable, is_copyable, Alloc>;
+        static_assert(
+            sizeof(typename manage::slot) <= sizeof(storage_type),
+            "insufficient storage size for allocator");
+        static_assert(
+            !is_relocatable || is_trivially_relocatable<Alloc>::value,
+            "trivially relocatable allocator required");
+        manage::create(&data_, alloc, std::forward<F>(f));
+        using handle = fn_handler<functor_type, false, is_const, R, Args...>;
+        manage_ = &manager_<functor_type, manage>::manage;
+        invoke_ = &handle::invoke;
+        this->template set_batch_<functor_type, false>();
+        stats_hooks::construct<functor_type>(stats_key(manage_), false);
+    }
+
+    // Target placement: local if fits and can be moved without throwing.
     template<class F>
-    void construct_(F&& f) {
+    struct placement {
         using functor_type = typename std::decay<F>::type;
-        constexpr bool fit_local_storage =
+        constexpr static bool fit_local_storage =
             sizeof(functor_type) <= sizeof(storage_type);
-        constexpr bool is_nothrow_movable =
-            std::is_nothrow_move_constructible<functor_type>::value;
-        constexpr bool use_local_storage =
-            fit_local_storage && is_nothrow_movable;
+        // Relocatable functions move local targets by memcpy.
+        constexpr static bool is_nothrow_movable = is_relocatable
+            ? is_trivially_relocatable<functor_type>::value
+            : std::is_nothrow_move_constructible<functor_type>::value;
+        constexpr static bool use_local_storage =
+            Storage::allow_local && fit_local_storage && is_nothrow_movable;
         // Check dynamic allocation allowed.
         static_assert(
             !no_alloc || fit_local_storage, "insufficient storage size");
+        static_assert(
+            !no_alloc || !is_relocatable || is_nothrow_movable,
+            "trivially relocatable target required");
         static_assert(
             !no_alloc || is_nothrow_movable, " nothrow move required");
+        static_assert(
+            !is_comparable || is_comparable_target<functor_type>::value,
+            "comparable target required (operator== or unique bytes)");
+
+        using tag = std::integral_constant<bool, use_local_storage>;
 
-        construct_(
+        static void profile() {
+            stats_hooks::store<function_data>(
+                sizeof(storage_type), sizeof(functor_type),
+                is_nothrow_movable);
+        }
+    };
+
+    // Trampoline of targets of type F (allocator independent).
+    template<class F>
+    using handler_ = fn_handler<
+        typename placement<F>::functor_type,
+        placement<F>::use_local_storage, is_const, R, Args...>;
+
+    using allocator_type = typename Storage::allocator;
+
+    // Dynamic storage by storage policy: new/delete.
+    template<class F, class Tag>
+    UNIVANG_FUNCTION_CONSTEXPR void construct_policy_(
+        F&& f, Tag tag, std::true_type /*new_delete*/) {
+        construct_(std::forward<F>(f), tag);
+    }
+
+    // Dynamic storage by storage policy: policy allocator.
+    template<class F, class Tag>
+    UNIVANG_FUNCTION_CONSTEXPR void construct_policy_(
+        F&& f, Tag tag, std::false_type /*new_delete*/) {
+        construct_(std::forward<F>(f), allocator_type(), tag);
+    }
+
+    template<class F>
+    UNIVANG_FUNCTION_CONSTEXPR void construct_(F&& f) {
+        construct_adopt_(
             std::forward<F>(f),
-            std::integral_constant<bool, use_local_storage>());
+            is_owning_pointer<typename std::decay<F>::type>());
+    }
+
+    template<class F>
+    UNIVANG_FUNCTION_CONSTEXPR void construct_adopt_(
+        F&& f, std::false_type /*owning_pointer*/) {
+        if(!constant_evaluated())
+            placement<F>::profile();
+        construct_policy_(
+            std::forward<F>(f), typename placement<F>::tag(),
+            std::is_void<allocator_type>());
+    }
+
+    // Owning pointer target, null pointers leave the function empty.
+    template<class F>
+    void construct_adopt_(F&& f, std::true_type /*owning_pointer*/) {
+        using adopted = fn_adopted<typename std::decay<F>::type>;
+        if(f != nullptr)
+            construct_adopt_(adopted{std::forward<F>(f)}, std::false_type());
+    }
+
+    // Dynamic storage allocated with alloc.allocate(size, align) and released
+    // with alloc.deallocate(p, size, align).
+    template<class F, class Alloc>
+    void construct_(F&& f, const Alloc& alloc) {
+        construct_adopt_(
+            std::forward<F>(f), alloc,
+            is_owning_pointer<typename std::decay<F>::type>());
+    }
+
+    template<class F, class Alloc>
+    void construct_adopt_(
+        F&& f, const Alloc& alloc, std::false_type /*owning_pointer*/) {
+        placement<F>::profile();
+        construct_(std::forward<F>(f), alloc, typename placement<F>::tag());
+    }
+
+    template<class F, class Alloc>
+    void construct_adopt_(
+        F&& f, const Alloc& alloc, std::true_type /*owning_pointer*/) {
+        using adopted = fn_adopted<typename std::decay<F>::type>;
+        if(f != nullptr)
+            construct_adopt_(
+                adopted{std::forward<F>(f)}, alloc, std::false_type());
     }
 
     void default_construct_() {
         invoke_ = &bad_call_;
         manage_ = nullptr;
+        this->reset_batch_();
     }
 
     void reset_() {
@@ -252,20 +1155,48 @@ protected:
         default_construct_();
     }
 
+    void migrate_() {
+        if(manage_ != nullptr)
+            manage_(exec_op::MIGRATE, &data_, nullptr);
+    }
+
     void copy_construct_(const function_data& rhs) {
         invoke_ = rhs.invoke_;
         manage_ = rhs.manage_;
-        if(manage_ != nullptr)
-            manage_(exec_op::COPY, rhs.get_data_(), &data_);
+        if(manage_ == nullptr)
+            return;
+        stats_hooks::copy(stats_key(manage_));
+        manage_(exec_op::COPY, rhs.get_data_(), &data_);
+        this->copy_batch_(rhs.batch_());
     }
 
     void copy_assign_(const function_data& rhs) {
         reset_();
         if(rhs.manage_ == nullptr)
             return;
+        stats_hooks::copy(stats_key(rhs.manage_));
         invoke_ = rhs.invoke_;
         manage_ = rhs.manage_;
         manage_(exec_op::COPY, rhs.get_data_(), &data_);
+        this->copy_batch_(rhs.batch_());
+    }
+
+    // Move target from rhs, rhs target storage left destroyed.
+    void move_data_(function_data& rhs) noexcept {
+        rhs.relocate_data_(&data_);
+    }
+
+    // Move target to dst, target storage left destroyed.
+    void relocate_data_(void* dst) noexcept {
+        relocate_data_(dst, std::integral_constant<bool, is_relocatable>());
+    }
+
+    void relocate_data_(void* dst, std::true_type /*tag*/) noexcept {
+        std::memcpy(dst, &data_, sizeof(storage_type));
+    }
+
+    void relocate_data_(void* dst, std::false_type /*tag*/) noexcept {
+        manage_(exec_op::MOVE, &data_, dst);
     }
 
     void move_construct_(function_data&& rhs) noexcept {
@@ -273,7 +1204,9 @@ protected:
         manage_ = rhs.manage_;
         if(manage_ == nullptr)
             return;
-        rhs.manage_(exec_op::MOVE, &rhs.data_, &data_);
+        this->copy_batch_(rhs.batch_());
+        stats_hooks::move(stats_key(manage_));
+        move_data_(rhs);
         rhs.default_construct_();
     }
 
@@ -281,53 +1214,91 @@ protected:
         reset_();
         if(rhs.manage_ == nullptr)
             return;
-        rhs.manage_(exec_op::MOVE, &rhs.data_, &data_);
+        stats_hooks::move(stats_key(rhs.manage_));
+        move_data_(rhs);
         invoke_ = rhs.invoke_;
         manage_ = rhs.manage_;
+        this->copy_batch_(rhs.batch_());
+        rhs.default_construct_();
+    }
+
+    // Take over target of a compatible instantiation (see transplantable):
+    // handlers do not depend on storage size, so invoke_/manage_ are reused.
+    template<size_t RhsSize, fn_opt RhsOptions, class RhsStorage>
+    void transplant_(
+        const function_data<
+            RhsSize, RhsOptions, RhsStorage, IsConst, R, Args...>& rhs) {
+        reset_();
+        if(rhs.manage_ == nullptr)
+            return;
+        stats_hooks::copy(stats_key(rhs.manage_));
+        rhs.manage_(exec_op::COPY, rhs.get_data_(), &data_);
+        invoke_ = rhs.invoke_;
+        manage_ = rhs.manage_;
+        this->copy_batch_(rhs.batch_());
+    }
+
+    template<size_t RhsSize, fn_opt RhsOptions, class RhsStorage>
+    void transplant_(
+        function_data<RhsSize, RhsOptions, RhsStorage, IsConst, R, Args...>&&
+            rhs) noexcept {
+        reset_();
+        if(rhs.manage_ == nullptr)
+            return;
+        stats_hooks::move(stats_key(rhs.manage_));
+        rhs.relocate_data_(&data_);
+        invoke_ = rhs.invoke_;
+        manage_ = rhs.manage_;
+        this->copy_batch_(rhs.batch_());
         rhs.default_construct_();
     }
 };
 
 // Const/mutable operator versions inheritance layer.
 //============================================================================
-template<class Enable, class Sig, size_t Size, fn_opt Options>
+template<class Enable, class Sig, size_t Size, fn_opt Options, class Storage>
 struct function_call_base;
 
 // Common versions.
-template<size_t Size, fn_opt Options, class R, class... Args>
-struct function_call_base<
-    enable_if_not_once<Options>, R(Args...), Size, Options>
-    : function_data<Size, Options, false, R, Args...> {
+template<size_t Size, fn_opt Options, class Storage, class R, class... Args>
+struct UNIVANG_TRIVIAL_ABI function_call_base<
+    enable_if_not_once<Options>, R(Args...), Size, Options, Storage>
+    : function_data<Size, Options, Storage, false, R, Args...> {
     R operator()(Args... args) {
+        stats_hooks::call(stats_key(this->manage_));
         return this->invoke_(this->get_data_(), static_cast<Args&&>(args)...);
     }
 };
 
-template<size_t Size, fn_opt Options, class R, class... Args>
-struct function_call_base<
-    enable_if_not_once<Options>, R(Args...) const, Size, Options>
-    : function_data<Size, Options, true, R, Args...> {
+template<size_t Size, fn_opt Options, class Storage, class R, class... Args>
+struct UNIVANG_TRIVIAL_ABI function_call_base<
+    enable_if_not_once<Options>, R(Args...) const, Size, Options, Storage>
+    : function_data<Size, Options, Storage, true, R, Args...> {
     R operator()(Args... args) const {
+        stats_hooks::call(stats_key(this->manage_));
         return this->invoke_(this->get_data_(), static_cast<Args&&>(args)...);
     }
 };
 
 // Call-once versions (both not const).
-template<size_t Size, fn_opt Options, class R, class... Args>
-struct function_call_base<enable_if_once<Options>, R(Args...), Size, Options>
-    : function_data<Size, Options, false, R, Args...> {
+template<size_t Size, fn_opt Options, class Storage, class R, class... Args>
+struct UNIVANG_TRIVIAL_ABI function_call_base<
+    enable_if_once<Options>, R(Args...), Size, Options, Storage>
+    : function_data<Size, Options, Storage, false, R, Args...> {
     R operator()(Args... args) {
+        stats_hooks::call(stats_key(this->manage_));
         auto moved_self = std::move(*this);
         return moved_self.invoke_(
             moved_self.get_data_(), static_cast<Args&&>(args)...);
     }
 };
 
-template<size_t Size, fn_opt Options, class R, class... Args>
-struct function_call_base<
-    enable_if_once<Options>, R(Args...) const, Size, Options>
-    : function_data<Size, Options, true, R, Args...> {
+template<size_t Size, fn_opt Options, class Storage, class R, class... Args>
+struct UNIVANG_TRIVIAL_ABI function_call_base<
+    enable_if_once<Options>, R(Args...) const, Size, Options, Storage>
+    : function_data<Size, Options, Storage, true, R, Args...> {
     R operator()(Args... args) {
+        stats_hooks::call(stats_key(this->manage_));
         auto moved_self = std::move(*this);
         return moved_self.invoke_(
             moved_self.get_data_(), static_cast<Args&&>(args)...);
@@ -336,13 +1307,13 @@ struct function_call_base<
 
 // Optional copy/move construction inheritance layer.
 //============================================================================
-template<class Enable, class Sig, size_t Size, fn_opt Options>
+template<class Enable, class Sig, size_t Size, fn_opt Options, class Storage>
 struct function_base;
 
-template<class Sig, std::size_t Size, fn_opt Options>
+template<class Sig, std::size_t Size, fn_opt Options, class Storage>
 struct function_base<
-    enable_if_cpmove<Options, fn_opt::none>, Sig, Size, Options>
-    : function_call_base<void, Sig, Size, Options> {
+    enable_if_cpmove<Options, fn_opt::none>, Sig, Size, Options, Storage>
+    : function_call_base<void, Sig, Size, Options, Storage> {
     constexpr function_base() noexcept = default;
     function_base(const function_base& /*rhs*/) = delete;
     function_base& operator=(const function_base& /*rhs*/) = delete;
@@ -350,10 +1321,10 @@ struct function_base<
     function_base& operator=(function_base&& /*rhs*/) = delete;
 };
 
-template<class Sig, std::size_t Size, fn_opt Options>
-struct function_base<
-    enable_if_cpmove<Options, fn_opt::move>, Sig, Size, Options>
-    : function_call_base<void, Sig, Size, Options> {
+template<class Sig, std::size_t Size, fn_opt Options, class Storage>
+struct UNIVANG_TRIVIAL_ABI function_base<
+    enable_if_cpmove<Options, fn_opt::move>, Sig, Size, Options, Storage>
+    : function_call_base<void, Sig, Size, Options, Storage> {
     constexpr function_base() noexcept = default;
     function_base(const function_base& /*rhs*/) = delete;
     function_base& operator=(const function_base& /*rhs*/) = delete;
@@ -366,10 +1337,10 @@ struct function_base<
     }
 };
 
-template<class Sig, std::size_t Size, fn_opt Options>
-struct function_base<
-    enable_if_cpmove<Options, fn_opt::copy>, Sig, Size, Options>
-    : function_call_base<void, Sig, Size, Options> {
+template<class Sig, std::size_t Size, fn_opt Options, class Storage>
+struct UNIVANG_TRIVIAL_ABI function_base<
+    enable_if_cpmove<Options, fn_opt::copy>, Sig, Size, Options, Storage>
+    : function_call_base<void, Sig, Size, Options, Storage> {
     constexpr function_base() noexcept = default;
     function_base(const function_base& rhs) {
         this->copy_construct_(rhs);
@@ -380,10 +1351,10 @@ struct function_base<
     }
 };
 
-template<class Sig, std::size_t Size, fn_opt Options>
-struct function_base<
-    enable_if_cpmove<Options, fn_opt::copy_move>, Sig, Size, Options>
-    : function_call_base<void, Sig, Size, Options> {
+template<class Sig, std::size_t Size, fn_opt Options, class Storage>
+struct UNIVANG_TRIVIAL_ABI function_base<
+    enable_if_cpmove<Options, fn_opt::copy_move>, Sig, Size, Options, Storage>
+    : function_call_base<void, Sig, Size, Options, Storage> {
     constexpr function_base() noexcept = default;
     function_base(const function_base& rhs) {
         this->copy_construct_(rhs);
@@ -404,19 +1375,118 @@ struct function_base<
 template<class T>
 struct is_function : std::false_type {};
 
-template<class F, size_t Size, fn_opt Options>
-struct is_function<basic_function<F, Size, Options>> : std::true_type {};
+template<class F, size_t Size, fn_opt Options, class Storage>
+struct is_function<basic_function<F, Size, Options, Storage>>
+    : std::true_type {};
+
+// Access to type erased internals for library extensions.
+struct function_access {
+    // Manager identifies target type and placement (nullptr when empty).
+    template<class Function>
+    static const void* manager(const Function& f) noexcept {
+        return stats_key(f.manage_);
+    }
+
+    // Target is of type F: invoke_ is the F trampoline. Identical code
+    // folding may merge trampolines of targets with identical code, which
+    // then also behave identically.
+    template<class F, class Function>
+    static bool holds(const Function& f) noexcept {
+        return f.invoke_ == &Function::template handler_<F>::invoke;
+    }
+
+    // Target equality and hash (fn_opt::comparable).
+    template<class Function>
+    static bool equal(const Function& lhs, const Function& rhs) {
+        return lhs.equal_(rhs);
+    }
+
+    template<class Function>
+    static size_t hash(const Function& f) {
+        return f.hash_();
+    }
+
+    // Direct (inlinable) call of target known to be of type F.
+    template<class F, class Function, class... A>
+    static typename Function::result_type call(const Function& f, A&&... args) {
+        return Function::template handler_<F>::invoke(
+            f.get_data_(), std::forward<A>(args)...);
+    }
+};
+
+// Target of From can be taken over by To as is: same signature, To storage
+// is at least as large and aligned, and anything From may hold (operations,
+// placement, allocator, relocation) is valid for To.
+template<class To, class From>
+struct transplantable : std::false_type {};
+
+template<
+    class Sig, size_t ToSize, fn_opt ToOptions, class ToStorage,
+    size_t FromSize, fn_opt FromOptions, class FromStorage>
+struct transplantable<
+    basic_function<Sig, ToSize, ToOptions, ToStorage>,
+    basic_function<Sig, FromSize, FromOptions, FromStorage>> {
+    using to_storage = local_storage<ToSize, ToStorage>;
+    using from_storage = local_storage<FromSize, FromStorage>;
+    constexpr static bool value =
+        !std::is_same<
+            basic_function<Sig, ToSize, ToOptions, ToStorage>,
+            basic_function<Sig, FromSize, FromOptions, FromStorage>>::value &&
+        sizeof(to_storage) >= sizeof(from_storage) &&
+        alignof(to_storage) >= alignof(from_storage) &&
+        fn_opt_enabled(FromOptions, ToOptions & fn_opt::copy_move) &&
+        std::is_same<
+            typename ToStorage::allocator,
+            typename FromStorage::allocator>::value &&
+        (!FromStorage::allow_local || ToStorage::allow_local) &&
+        (no_alloc_enabled<FromOptions, FromStorage>() ||
+         !no_alloc_enabled<ToOptions, ToStorage>()) &&
+        (relocatable_enabled<FromOptions, FromStorage>() ||
+         !relocatable_enabled<ToOptions, ToStorage>()) &&
+        (fn_opt_enabled(FromOptions, fn_opt::batch) ||
+         !fn_opt_enabled(ToOptions, fn_opt::batch)) &&
+        (fn_opt_enabled(FromOptions, fn_opt::comparable) ||
+         !fn_opt_enabled(ToOptions, fn_opt::comparable));
+};
+
+// Exact fit storage for target F: local storage size and alignment of F
+// (at least those of the dynamic storage pointer). Targets which may throw
+// on move (not trivially relocatable for relocatable functions) are always
+// stored dynamically, the local storage then holds only the pointer.
+template<class F>
+struct exact_fit {
+    constexpr static fn_opt options = std::is_copy_constructible<F>::value
+        ? fn_opt::copy_move
+        : fn_opt::move;
+
+    static constexpr bool local(fn_opt opts) {
+        return relocatable_enabled<fn_opt::none, fn_default_storage>() ||
+                fn_opt_enabled(opts, fn_opt::relocatable)
+            ? is_trivially_relocatable<F>::value
+            : std::is_nothrow_move_constructible<F>::value;
+    }
+    static constexpr size_t size(fn_opt opts) {
+        return local(opts) && sizeof(F) > sizeof(void*) ? sizeof(F)
+                                                        : sizeof(void*);
+    }
+    static constexpr size_t align(fn_opt opts) {
+        return local(opts) && alignof(F) > alignof(void*) ? alignof(F)
+                                                          : alignof(void*);
+    }
+};
 
 } // namespace function
 } // namespace detail
 
 // Basic function template.
 //============================================================================
-template<class Sig, size_t Size, fn_opt Options>
-class basic_function
-    : private detail::function::function_base<void, Sig, Size, Options> {
+template<class Sig, size_t Size, fn_opt Options, class Storage>
+class UNIVANG_TRIVIAL_ABI basic_function
+    : private detail::function::
+          function_base<void, Sig, Size, Options, Storage> {
 private:
-    using base = detail::function::function_base<void, Sig, Size, Options>;
+    using base =
+        detail::function::function_base<void, Sig, Size, Options, Storage>;
 
     // TODO(dsokolov): add const/noexcept checks
     template<class T>
@@ -424,18 +1494,80 @@ private:
         !detail::function::is_function<typename std::decay<T>::type>::value,
         bool>::type;
 
+    template<class T, fn_opt Required>
+    using accept_transplant = typename std::enable_if<
+        detail::function::transplantable<basic_function, T>::value &&
+            detail::function::fn_opt_enabled(T::options, Required),
+        bool>::type;
+
+    template<class, size_t, fn_opt, class>
+    friend class basic_function;
+    friend struct detail::function::function_access;
+
 public:
+    constexpr static fn_opt options = Options;
+
     constexpr basic_function() noexcept = default;
     constexpr basic_function(std::nullptr_t) noexcept {
     }
 
+    // Conversion from a narrower instantiation (e.g. make_function result),
+    // the target is taken over without wrapping.
+    template<
+        size_t RhsSize, fn_opt RhsOptions, class RhsStorage,
+        accept_transplant<
+            basic_function<Sig, RhsSize, RhsOptions, RhsStorage>,
+            fn_opt::copy> = true>
+    basic_function(
+        const basic_function<Sig, RhsSize, RhsOptions, RhsStorage>& rhs) {
+        this->transplant_(rhs);
+    }
+
+    template<
+        size_t RhsSize, fn_opt RhsOptions, class RhsStorage,
+        accept_transplant<
+            basic_function<Sig, RhsSize, RhsOptions, RhsStorage>,
+            fn_opt::move> = true>
+    basic_function(
+        basic_function<Sig, RhsSize, RhsOptions, RhsStorage>&& rhs) noexcept {
+        this->transplant_(std::move(rhs));
+    }
+
+    template<
+        size_t RhsSize, fn_opt RhsOptions, class RhsStorage,
+        accept_transplant<
+            basic_function<Sig, RhsSize, RhsOptions, RhsStorage>,
+            fn_opt::copy> = true>
+    basic_function& operator=(
+        const basic_function<Sig, RhsSize, RhsOptions, RhsStorage>& rhs) {
+        this->transplant_(rhs);
+        return *this;
+    }
+
+    template<
+        size_t RhsSize, fn_opt RhsOptions, class RhsStorage,
+        accept_transplant<
+            basic_function<Sig, RhsSize, RhsOptions, RhsStorage>,
+            fn_opt::move> = true>
+    basic_function& operator=(
+        basic_function<Sig, RhsSize, RhsOptions, RhsStorage>&& rhs) noexcept {
+        this->transplant_(std::move(rhs));
+        return *this;
+    }
+
     basic_function& operator=(std::nullptr_t) {
         this->reset_();
         return *this;
     }
 
+    // Constant expression (C++20) for stateless targets, e.g. captureless
+    // lambdas, and function pointers of the exact signature stored locally:
+    //   constinit function<void(int)> handlers[] = {[](int) {}, &on_int};
+    // Owning pointers to callables (unique_ptr, shared_ptr) are stored as
+    // they are and called through, no wrapper is allocated; null pointers
+    // give empty functions.
     template<class F, accept_function<F> = true>
-    basic_function(F&& f) {
+    UNIVANG_FUNCTION_CONSTEXPR basic_function(F&& f) {
         this->construct_(std::forward<F>(f));
     }
 
@@ -452,10 +1584,98 @@ public:
         this->construct_(std::forward<F>(f));
     }
 
+    // Adopt C callback: stored locally (no allocation unless Size is less
+    // than two pointers), calls go to fn(context, args...). Null fn leaves
+    // the function empty.
+    basic_function(
+        typename base::c_callback_type::function_type fn, void* context) {
+        if(fn != nullptr)
+            this->construct_(typename base::c_callback_type{fn, context});
+    }
+
+    // Targets not fitting local storage are placed by allocator (e.g.
+    // fn_arena_alloc), which is kept next to the target pointer.
+    template<class Alloc, class F, accept_function<F> = true>
+    basic_function(std::allocator_arg_t, const Alloc& alloc, F&& f) {
+        this->construct_(std::forward<F>(f), alloc);
+    }
+
+    template<class Alloc, class F, accept_function<F> = true>
+    void assign(std::allocator_arg_t, const Alloc& alloc, F&& f) {
+        this->reset_();
+        this->construct_(std::forward<F>(f), alloc);
+    }
+
     void reset() {
         this->reset_();
     }
 
+    // Call target for each of count inputs (fn_opt::batch): one indirect
+    // call, the loop is compiled with the target.
+    template<
+        class In, fn_opt O = Options,
+        typename std::enable_if<
+            detail::function::fn_opt_enabled(O, fn_opt::batch), bool>::type =
+            true>
+    void invoke_batch(
+        const In* in, typename base::batch_result_type* out, size_t count) {
+        this->call_batch_(in, out, count);
+    }
+
+    // Checked form: all in_count inputs are processed, out_count smaller
+    // than in_count throws std::length_error.
+    template<
+        class In, fn_opt O = Options,
+        typename std::enable_if<
+            detail::function::fn_opt_enabled(O, fn_opt::batch), bool>::type =
+            true>
+    void invoke_batch(
+        const In* in, size_t in_count, typename base::batch_result_type* out,
+        size_t out_count) {
+        if(out_count < in_count)
+            throw std::length_error("batch output shorter than input");
+        this->call_batch_(in, out, in_count);
+    }
+
+#if defined(__cpp_lib_span)
+    // All inputs are processed, out shorter than in throws std::length_error.
+    template<
+        class In, size_t InExtent, size_t OutExtent, fn_opt O = Options,
+        typename std::enable_if<
+            detail::function::fn_opt_enabled(O, fn_opt::batch), bool>::type =
+            true>
+    void invoke_batch(
+        std::span<const In, InExtent> in,
+        std::span<typename base::batch_result_type, OutExtent> out) {
+        static_assert(
+            InExtent == std::dynamic_extent ||
+                OutExtent == std::dynamic_extent || OutExtent >= InExtent,
+            "batch output shorter than input");
+        invoke_batch(in.data(), in.size(), out.data(), out.size());
+    }
+#endif
+
+    // C callback calling the target: cb.fn(cb.context, args...) with no
+    // thunk in between, for C APIs taking a function and a context pointer.
+    // Valid while the function is alive and not moved from (local targets
+    // move with it); fn is nullptr for empty functions.
+    typename base::c_callback_type c_callback() noexcept {
+        return this->c_callback_();
+    }
+
+    template<
+        bool IsConst = base::is_const,
+        typename std::enable_if<IsConst, bool>::type = true>
+    typename base::c_callback_type c_callback() const noexcept {
+        return this->c_callback_();
+    }
+
+    // Re-place allocator stored target when the allocator provides
+    // migration_target() (e.g. onto the calling thread NUMA node).
+    void migrate() {
+        this->migrate_();
+    }
+
     using typename base::result_type;
     using base::operator();
     using base::operator bool;
@@ -467,49 +1687,185 @@ public:
     }
 };
 
-template<class F, std::size_t Size, fn_opt Options>
+template<class F, std::size_t Size, fn_opt Options, class Storage>
 inline void swap(
-    basic_function<F, Size, Options>& lhs,
-    basic_function<F, Size, Options>& rhs) noexcept {
+    basic_function<F, Size, Options, Storage>& lhs,
+    basic_function<F, Size, Options, Storage>& rhs) noexcept {
     lhs.swap(rhs);
 }
 
-template<class F, std::size_t Size, fn_opt Options>
+template<class F, std::size_t Size, fn_opt Options, class Storage>
 inline bool operator==(
-    std::nullptr_t, basic_function<F, Size, Options> const& f) {
+    std::nullptr_t, basic_function<F, Size, Options, Storage> const& f) {
     return !f;
 }
 
-template<class F, std::size_t Size, fn_opt Options>
+template<class F, std::size_t Size, fn_opt Options, class Storage>
 inline bool operator==(
-    basic_function<F, Size, Options> const& f, std::nullptr_t) {
+    basic_function<F, Size, Options, Storage> const& f, std::nullptr_t) {
     return !f;
 }
 
-template<class F, std::size_t Size, fn_opt Options>
+template<class F, std::size_t Size, fn_opt Options, class Storage>
 inline bool operator!=(
-    std::nullptr_t, basic_function<F, Size, Options> const& f) {
+    std::nullptr_t, basic_function<F, Size, Options, Storage> const& f) {
     return f;
 }
 
-template<class F, std::size_t Size, fn_opt Options>
+template<class F, std::size_t Size, fn_opt Options, class Storage>
 inline bool operator!=(
-    basic_function<F, Size, Options> const& f, std::nullptr_t) {
+    basic_function<F, Size, Options, Storage> const& f, std::nullptr_t) {
     return f;
 }
 
+// Functions with fn_opt::comparable are equal when both are empty or hold
+// equal targets of the same type and placement (targets kept by different
+// allocators differ): duplicate subscriptions and tasks can be found by
+// value, e.g. in std::unordered_set.
+template<
+    class F, std::size_t Size, fn_opt Options, class Storage,
+    typename std::enable_if<
+        detail::function::fn_opt_enabled(Options, fn_opt::comparable),
+        bool>::type = true>
+inline bool operator==(
+    basic_function<F, Size, Options, Storage> const& lhs,
+    basic_function<F, Size, Options, Storage> const& rhs) {
+    return detail::function::function_access::equal(lhs, rhs);
+}
+
+template<
+    class F, std::size_t Size, fn_opt Options, class Storage,
+    typename std::enable_if<
+        detail::function::fn_opt_enabled(Options, fn_opt::comparable),
+        bool>::type = true>
+inline bool operator!=(
+    basic_function<F, Size, Options, Storage> const& lhs,
+    basic_function<F, Size, Options, Storage> const& rhs) {
+    return !detail::function::function_access::equal(lhs, rhs);
+}
+
+// Relocatable functions keep only trivially relocatable targets inline.
+template<class F, std::size_t Size, fn_opt Options, class Storage>
+struct is_trivially_relocatable<basic_function<F, Size, Options, Storage>>
+    : std::integral_constant<
+          bool,
+          detail::function::relocatable_enabled<Options, Storage>()> {};
+
+template<class P>
+struct is_trivially_relocatable<detail::function::fn_adopted<P>>
+    : is_trivially_relocatable<P> {};
+
 // Common function types declaration.
 //============================================================================
 // Generic function.
-template<class F, fn_opt Options = fn_opt::copy_move>
-using function = basic_function<F, detail::function::default_size, Options>;
+template<
+    class F, fn_opt Options = fn_opt::copy_move,
+    class Storage = fn_default_storage>
+using function =
+    basic_function<F, detail::function::default_size, Options, Storage>;
 
 // Function with adjustable preallocated size.
-template<class F, size_t Size, fn_opt Options = fn_opt::copy_move>
-using so_function = basic_function<F, Size, Options>;
+template<
+    class F, size_t Size, fn_opt Options = fn_opt::copy_move,
+    class Storage = fn_default_storage>
+using so_function = basic_function<F, Size, Options, Storage>;
 
 // Fixed size function, dynamic allocation forbidden, no copy-move constructors.
 template<class F, size_t Size, fn_opt Options = fn_opt::none>
-using fs_function = basic_function<F, Size, Options | fn_opt::no_alloc>;
+using fs_function = basic_function<F, Size, Options, fn_inline_storage>;
+
+// Cache line aligned function, storage fills the lines after the header: no
+// false sharing between neighbouring slots of per-core arrays.
+struct fn_cache_line_storage : fn_default_storage {
+    constexpr static size_t alignment = detail::function::header_size;
+    constexpr static size_t object_alignment =
+        detail::function::cache_line_size;
+};
 
+namespace detail {
+namespace function {
+
+// Storage size filling Lines cache lines: the header (with the batch entry
+// point when enabled) is padded to the storage alignment.
+inline constexpr size_t cl_storage_size(size_t lines, fn_opt options) {
+    return cache_line_size * lines -
+        (header_size +
+         (fn_opt_enabled(options, fn_opt::batch) ? sizeof(void*) : 0) +
+         fn_cache_line_storage::alignment - 1) /
+        fn_cache_line_storage::alignment * fn_cache_line_storage::alignment;
+}
+
+} // namespace function
+} // namespace detail
+
+template<class F, size_t Lines = 1, fn_opt Options = fn_opt::copy_move>
+using cl_function = basic_function<
+    F, detail::function::cl_storage_size(Lines, Options), Options,
+    fn_cache_line_storage>;
+
+static_assert(
+    sizeof(cl_function<void()>) == detail::function::cache_line_size &&
+        alignof(cl_function<void()>) == detail::function::cache_line_size,
+    "cl_function must fill a cache line");
+
+static_assert(
+    sizeof(cl_function<int(int), 1, fn_opt::copy_move | fn_opt::batch>) ==
+        detail::function::cache_line_size,
+    "cl_function with batch entry point must fill a cache line");
+
+// Function with local storage sized and aligned exactly for F (a pointer
+// for F with throwing move, which is always allocated).
+template<class Sig, class F, fn_opt Options = detail::function::exact_fit<
+                                 typename std::decay<F>::type>::options>
+using exact_function = basic_function<
+    Sig,
+    detail::function::exact_fit<typename std::decay<F>::type>::size(Options),
+    Options,
+    fn_aligned_storage<detail::function::exact_fit<
+        typename std::decay<F>::type>::align(Options)>>;
+
+// Function holding f in exactly fitting local storage, copyable when f is.
+// Converts to wider functions of the same signature (e.g. function<Sig>)
+// without wrapping: make_function<void(int)>([this](int v) { ... }).
+template<class Sig, class F>
+inline exact_function<Sig, F> make_function(F&& f) {
+    return exact_function<Sig, F>(std::forward<F>(f));
+}
+
+template<class Sig, fn_opt Options, class F>
+inline exact_function<Sig, F, Options> make_function(F&& f) {
+    return exact_function<Sig, F, Options>(std::forward<F>(f));
+}
+
+namespace detail {
+namespace function {
+
+// std::hash of functions, disabled without fn_opt::comparable.
+template<class Function, bool Enabled>
+struct function_hash {
+    function_hash() = delete;
+    function_hash(const function_hash&) = delete;
+    function_hash& operator=(const function_hash&) = delete;
+};
+
+template<class Function>
+struct function_hash<Function, true> {
+    size_t operator()(const Function& f) const {
+        return function_access::hash(f);
+    }
+};
+
+} // namespace function
+} // namespace detail
 } // namespace univang
+
+namespace std {
+
+template<class F, size_t Size, univang::fn_opt Options, class Storage>
+struct hash<univang::basic_function<F, Size, Options, Storage>>
+    : univang::detail::function::function_hash<
+          univang::basic_function<F, Size, Options, Storage>,
+          univang::detail::function::fn_opt_enabled(
+              Options, univang::fn_opt::comparable)> {};
+
+} // namespace std
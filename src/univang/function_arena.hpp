@@ -0,0 +1,204 @@
+#pragma once
+// Monotonic arena for request-scoped function targets.
+//============================================================================
+#if __cplusplus < 201703L && (!defined(_MSVC_LANG) || _MSVC_LANG < 201703L)
+#error "function_arena.hpp requires C++17 (aligned operator new)"
+#endif
+
+#include "function.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace univang {
+
+class fn_arena;
+
+// Function allocator placing targets into an arena. Deallocation is a no-op,
+// destroying a function only runs the target destructor. Default constructed
+// allocator uses the current fn_arena_scope arena, or the general heap when
+// there is none.
+class fn_arena_alloc {
+public:
+    fn_arena_alloc() noexcept;
+
+    explicit fn_arena_alloc(fn_arena& arena) noexcept : arena_(&arena) {
+    }
+
+    void* allocate(size_t size, size_t align);
+
+    void deallocate(void* p, size_t /*size*/, size_t align) noexcept {
+        if(arena_ == nullptr)
+            ::operator delete(p, std::align_val_t(align));
+    }
+
+private:
+    fn_arena* arena_;
+};
+
+template<>
+struct is_trivially_relocatable<fn_arena_alloc> : std::true_type {};
+
+// Bump allocator, memory is reclaimed by reset() only. Blocks are kept for
+// reuse after reset. Functions holding arena targets must be destroyed
+// before reset or arena destruction.
+//============================================================================
+class fn_arena {
+public:
+    constexpr static size_t default_block_size = 4096;
+
+    explicit fn_arena(size_t block_size = default_block_size) noexcept
+        : block_size_(block_size) {
+    }
+
+    // First block is external buffer, never freed by the arena.
+    fn_arena(
+        void* buffer, size_t size,
+        size_t block_size = default_block_size) noexcept
+        : block_size_(block_size) {
+        char* p = align_up_(static_cast<char*>(buffer), alignof(block));
+        size_t skip = static_cast<size_t>(p - static_cast<char*>(buffer));
+        if(size <= skip + sizeof(block))
+            return;
+        head_ = current_ = ::new(p) block{nullptr, size - skip, false};
+        pos_ = current_->begin();
+        end_ = current_->end();
+    }
+
+    fn_arena(const fn_arena&) = delete;
+    fn_arena& operator=(const fn_arena&) = delete;
+
+    ~fn_arena() {
+        block* b = head_;
+        while(b != nullptr) {
+            block* next = b->next;
+            if(b->owned)
+                std::free(b);
+            b = next;
+        }
+    }
+
+    void* allocate(size_t size, size_t align) {
+        char* p = align_up_(pos_, align);
+        if(p == nullptr || p + size > end_)
+            p = align_up_(next_block_(size + align), align);
+        pos_ = p + size;
+        used_ += size;
+        return p;
+    }
+
+    // Reclaim all memory at once.
+    void reset() noexcept {
+        current_ = head_;
+        pos_ = current_ ? current_->begin() : nullptr;
+        end_ = current_ ? current_->end() : nullptr;
+        used_ = 0;
+    }
+
+    // Bytes allocated since last reset.
+    size_t used() const noexcept {
+        return used_;
+    }
+
+    fn_arena_alloc allocator() noexcept {
+        return fn_arena_alloc(*this);
+    }
+
+private:
+    struct alignas(std::max_align_t) block {
+        block* next;
+        size_t size;
+        bool owned;
+
+        char* begin() noexcept {
+            return reinterpret_cast<char*>(this + 1);
+        }
+        char* end() noexcept {
+            return reinterpret_cast<char*>(this) + size;
+        }
+    };
+
+    block* head_ = nullptr;
+    block* current_ = nullptr;
+    char* pos_ = nullptr;
+    char* end_ = nullptr;
+    size_t block_size_;
+    size_t used_ = 0;
+
+    static char* align_up_(char* p, size_t align) noexcept {
+        if(p == nullptr)
+            return nullptr;
+        auto v = reinterpret_cast<std::uintptr_t>(p);
+        return p + ((align - v % align) % align);
+    }
+
+    // Move to next block with at least size bytes, reusing kept blocks.
+    char* next_block_(size_t size) {
+        block* next = current_ ? current_->next : head_;
+        if(next == nullptr ||
+           static_cast<size_t>(next->end() - next->begin()) < size) {
+            size_t bytes = sizeof(block) + size;
+            if(bytes < block_size_)
+                bytes = block_size_;
+            void* mem = std::malloc(bytes);
+            if(mem == nullptr)
+                throw std::bad_alloc();
+            block* b = ::new(mem) block{next, bytes, true};
+            if(current_ != nullptr)
+                current_->next = b;
+            else
+                head_ = b;
+            next = b;
+        }
+        current_ = next;
+        pos_ = current_->begin();
+        end_ = current_->end();
+        return pos_;
+    }
+};
+
+// Makes arena current for the calling thread until scope exit, scopes nest.
+class fn_arena_scope {
+public:
+    explicit fn_arena_scope(fn_arena& arena) noexcept
+        : previous_(current_()) {
+        current_() = &arena;
+    }
+
+    fn_arena_scope(const fn_arena_scope&) = delete;
+    fn_arena_scope& operator=(const fn_arena_scope&) = delete;
+
+    ~fn_arena_scope() {
+        current_() = previous_;
+    }
+
+    static fn_arena* current() noexcept {
+        return current_();
+    }
+
+private:
+    fn_arena* previous_;
+
+    static fn_arena*& current_() noexcept {
+        static thread_local fn_arena* arena = nullptr;
+        return arena;
+    }
+};
+
+// Storage policy: targets not fitting local storage go to the current arena.
+struct fn_arena_storage : fn_default_storage {
+    using allocator = fn_arena_alloc;
+};
+
+inline fn_arena_alloc::fn_arena_alloc() noexcept
+    : arena_(fn_arena_scope::current()) {
+}
+
+inline void* fn_arena_alloc::allocate(size_t size, size_t align) {
+    if(arena_ == nullptr)
+        return ::operator new(size, std::align_val_t(align));
+    return arena_->allocate(size, align);
+}
+
+} // namespace univang
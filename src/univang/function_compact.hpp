@@ -0,0 +1,311 @@
+#pragma once
+// Compact function: the stored type is identified by a 32-bit index into a
+// process-wide registry of {invoke, manage} pairs instead of two pointers,
+// leaving 12 more bytes (on 64-bit) for the target in the same footprint.
+//============================================================================
+#include "function.hpp"
+
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+
+#ifndef UNIVANG_COMPACT_REGISTRY_CAPACITY
+#define UNIVANG_COMPACT_REGISTRY_CAPACITY 65536
+#endif
+
+namespace univang {
+namespace detail {
+namespace function {
+
+// Registry entry, invoke is cast back to the signature call type.
+struct compact_entry {
+    void (*invoke)();
+    void (*manage)(exec_op, void*, void*);
+};
+
+constexpr static uint32_t compact_capacity =
+    UNIVANG_COMPACT_REGISTRY_CAPACITY;
+
+// Zero-initialized table, untouched pages are never committed. Entries are
+// written once before their index is published; index 0 means empty.
+inline compact_entry* compact_table() noexcept {
+    static compact_entry table[compact_capacity];
+    return table;
+}
+
+inline uint32_t compact_register(compact_entry entry) {
+    static std::mutex mutex;
+    static uint32_t count = 1;
+    std::lock_guard<std::mutex> lock(mutex);
+    if(count == compact_capacity)
+        throw std::length_error("compact function registry is full");
+    compact_table()[count] = entry;
+    return count++;
+}
+
+// Index of handler/manager pair, registered on first construction.
+template<class CallFn, CallFn Invoke, class ExecFn, ExecFn Manage>
+inline uint32_t compact_index() {
+    static const uint32_t index = compact_register(
+        compact_entry{reinterpret_cast<void (*)()>(Invoke), Manage});
+    return index;
+}
+
+// Default local storage: same footprint as the default function pointers
+// plus default_size minus the index.
+constexpr static size_t compact_default_size =
+    default_size + header_size - sizeof(uint32_t);
+
+template<size_t Size, fn_opt Options, bool IsConst, class R, class... Args>
+class compact_data {
+public:
+    constexpr static bool is_const = IsConst;
+    constexpr static bool is_copyable = fn_opt_enabled(Options, fn_opt::copy);
+    constexpr static bool no_alloc = fn_opt_enabled(Options, fn_opt::no_alloc);
+
+    static_assert(
+        fn_opt_enabled(Options, fn_opt::move),
+        "compact function must be movable");
+    static_assert(
+        !fn_opt_enabled(Options, fn_opt::once),
+        "call-once compact function is not supported");
+
+    using result_type = R;
+
+    compact_data() noexcept : index_(0) {
+    }
+
+    compact_data(const compact_data& rhs) : index_(0) {
+        copy_from_(rhs);
+    }
+
+    compact_data(compact_data&& rhs) noexcept : index_(0) {
+        move_from_(rhs);
+    }
+
+    compact_data& operator=(const compact_data& rhs) {
+        if(this != &rhs) {
+            reset_();
+            copy_from_(rhs);
+        }
+        return *this;
+    }
+
+    compact_data& operator=(compact_data&& rhs) noexcept {
+        if(this != &rhs) {
+            reset_();
+            move_from_(rhs);
+        }
+        return *this;
+    }
+
+    ~compact_data() {
+        reset_();
+    }
+
+    explicit operator bool() const noexcept {
+        return index_ != 0;
+    }
+
+protected:
+    using call_fn = R (*)(void*, Args...);
+    using exec_fn = void (*)(exec_op, void*, void*);
+
+    // Plain array, not padded to alignment: index_ takes the tail bytes.
+    alignas(void*) unsigned char data_[Size];
+    uint32_t index_;
+
+    void* get_data_() const noexcept {
+        return const_cast<void*>(static_cast<const void*>(data_));
+    }
+
+    const compact_entry& entry_() const noexcept {
+        return compact_table()[index_];
+    }
+
+    R call_(Args... args) const {
+        if(index_ == 0)
+            throw std::bad_function_call();
+        auto invoke = reinterpret_cast<call_fn>(entry_().invoke);
+        return invoke(get_data_(), static_cast<Args&&>(args)...);
+    }
+
+    template<class F>
+    void construct_(F&& f) {
+        using functor_type = typename std::decay<F>::type;
+        constexpr bool fit_local_storage =
+            sizeof(functor_type) <= Size &&
+            alignof(functor_type) <= alignof(void*);
+        constexpr bool is_nothrow_movable =
+            std::is_nothrow_move_constructible<functor_type>::value;
+        static_assert(
+            !no_alloc || (fit_local_storage && is_nothrow_movable),
+            "insufficient storage size");
+        construct_(
+            std::forward<F>(f),
+            std::integral_constant<
+                bool, fit_local_storage && is_nothrow_movable>());
+    }
+
+    // Construct local.
+    template<class F>
+    void construct_(F&& f, std::true_type /*tag*/) {
+        using functor_type = typename std::decay<F>::type;
+        using handle = fn_handler<functor_type, true, is_const, R, Args...>;
+        using manage = fn_manager<functor_type, true, true, is_copyable>;
+        uint32_t index = compact_index<
+            call_fn, &handle::invoke, exec_fn, &manage::manage>();
+        ::new(get_data_()) functor_type(std::forward<F>(f));
+        index_ = index;
+    }
+
+    // Construct dynamic.
+    template<class F>
+    void construct_(F&& f, std::false_type /*tag*/) {
+        using functor_type = typename std::decay<F>::type;
+        static_assert(
+            sizeof(functor_type*) <= Size,
+            "insufficient storage size");
+        using handle = fn_handler<functor_type, false, is_const, R, Args...>;
+        using manage = fn_manager<functor_type, false, true, is_copyable>;
+        uint32_t index = compact_index<
+            call_fn, &handle::invoke, exec_fn, &manage::manage>();
+        *(functor_type**)(get_data_()) = new functor_type(std::forward<F>(f));
+        index_ = index;
+    }
+
+    void reset_() noexcept {
+        if(index_ == 0)
+            return;
+        entry_().manage(exec_op::DESTRUCT, get_data_(), nullptr);
+        index_ = 0;
+    }
+
+    void copy_from_(const compact_data& rhs) {
+        if(rhs.index_ == 0)
+            return;
+        rhs.entry_().manage(exec_op::COPY, rhs.get_data_(), get_data_());
+        index_ = rhs.index_;
+    }
+
+    void move_from_(compact_data& rhs) noexcept {
+        if(rhs.index_ == 0)
+            return;
+        rhs.entry_().manage(exec_op::MOVE, rhs.get_data_(), get_data_());
+        index_ = rhs.index_;
+        rhs.index_ = 0;
+    }
+};
+
+template<class Sig, size_t Size, fn_opt Options>
+struct compact_call_base;
+
+template<size_t Size, fn_opt Options, class R, class... Args>
+struct compact_call_base<R(Args...), Size, Options>
+    : compact_data<Size, Options, false, R, Args...> {
+    R operator()(Args... args) {
+        return this->call_(static_cast<Args&&>(args)...);
+    }
+};
+
+template<size_t Size, fn_opt Options, class R, class... Args>
+struct compact_call_base<R(Args...) const, Size, Options>
+    : compact_data<Size, Options, true, R, Args...> {
+    R operator()(Args... args) const {
+        return this->call_(static_cast<Args&&>(args)...);
+    }
+};
+
+} // namespace function
+} // namespace detail
+
+// Function identified by a 32-bit registry index: sizeof is Size plus 4
+// bytes rounded to pointer alignment, by default as function but with 44
+// instead of 32 bytes of local storage on 64-bit. Calls take one more
+// dependent load (index to registry entry), which pays off for large,
+// memory bound tables. Supports copy_move and move options (no_alloc to
+// forbid dynamic storage).
+template<
+    class Sig, size_t Size = detail::function::compact_default_size,
+    fn_opt Options = fn_opt::copy_move>
+class compact_function
+    : private detail::function::compact_call_base<Sig, Size, Options>,
+      private detail::function::copy_control<
+          detail::function::fn_opt_enabled(Options, fn_opt::copy)> {
+private:
+    using base = detail::function::compact_call_base<Sig, Size, Options>;
+
+    template<class T>
+    using accept_function = typename std::enable_if<
+        !std::is_same<typename std::decay<T>::type, compact_function>::value,
+        bool>::type;
+
+public:
+    compact_function() noexcept = default;
+    compact_function(std::nullptr_t) noexcept {
+    }
+
+    compact_function& operator=(std::nullptr_t) noexcept {
+        this->reset_();
+        return *this;
+    }
+
+    template<class F, accept_function<F> = true>
+    compact_function(F&& f) {
+        this->construct_(std::forward<F>(f));
+    }
+
+    template<class F, accept_function<F> = true>
+    compact_function& operator=(F&& f) {
+        this->reset_();
+        this->construct_(std::forward<F>(f));
+        return *this;
+    }
+
+    void reset() noexcept {
+        this->reset_();
+    }
+
+    using typename base::result_type;
+    using base::operator();
+    using base::operator bool;
+
+    void swap(compact_function& rhs) noexcept {
+        compact_function tmp = std::move(rhs);
+        rhs = std::move(*this);
+        *this = std::move(tmp);
+    }
+};
+
+template<class Sig, size_t Size, fn_opt Options>
+inline void swap(
+    compact_function<Sig, Size, Options>& lhs,
+    compact_function<Sig, Size, Options>& rhs) noexcept {
+    lhs.swap(rhs);
+}
+
+template<class Sig, size_t Size, fn_opt Options>
+inline bool operator==(
+    std::nullptr_t, const compact_function<Sig, Size, Options>& f) {
+    return !f;
+}
+
+template<class Sig, size_t Size, fn_opt Options>
+inline bool operator==(
+    const compact_function<Sig, Size, Options>& f, std::nullptr_t) {
+    return !f;
+}
+
+template<class Sig, size_t Size, fn_opt Options>
+inline bool operator!=(
+    std::nullptr_t, const compact_function<Sig, Size, Options>& f) {
+    return static_cast<bool>(f);
+}
+
+template<class Sig, size_t Size, fn_opt Options>
+inline bool operator!=(
+    const compact_function<Sig, Size, Options>& f, std::nullptr_t) {
+    return static_cast<bool>(f);
+}
+
+} // namespace univang
@@ -0,0 +1,183 @@
+#pragma once
+// Type-grouped function container: callables are stored contiguously per
+// target type and invoked group by group, so each group runs one trampoline
+// (or a fully inlined loop) instead of scattered indirect calls.
+//============================================================================
+#include "function.hpp"
+
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace univang {
+namespace detail {
+namespace function {
+
+// Arguments every callable of a group can get: lvalue references and
+// copyable values.
+template<class... Args>
+struct is_shared_args : std::true_type {};
+
+template<class A, class... Args>
+struct is_shared_args<A, Args...>
+    : std::integral_constant<
+          bool,
+          !std::is_rvalue_reference<A>::value &&
+              (std::is_lvalue_reference<A>::value ||
+               std::is_copy_constructible<A>::value) &&
+              is_shared_args<Args...>::value> {};
+
+// Group is identified by stored item type and target key (the manager for
+// functions, the type for concrete callables).
+template<class... Args>
+struct group_base {
+    const void* type;
+    const void* key;
+
+    group_base(const void* t, const void* k) noexcept : type(t), key(k) {
+    }
+    virtual ~group_base() = default;
+
+    virtual void invoke_all(Args&... args) = 0;
+    virtual size_t size() const noexcept = 0;
+};
+
+// Group of targets of type T, the loop is instantiated for T: concrete
+// callables are called directly, functions through the common trampoline.
+template<class T, class... Args>
+struct group : group_base<Args...> {
+    std::vector<T> items;
+
+    explicit group(const void* k) noexcept
+        : group_base<Args...>(type_key(), k) {
+    }
+
+    void invoke_all(Args&... args) override {
+        for(T& item : items)
+            item(args...);
+    }
+
+    size_t size() const noexcept override {
+        return items.size();
+    }
+
+    static const void* type_key() noexcept {
+        static const char id = 0;
+        return &id;
+    }
+};
+
+} // namespace function
+} // namespace detail
+
+template<class Sig>
+class function_group;
+
+// Callables invoked together with the same arguments (e.g. event handlers).
+// Callables are grouped by type: concrete callables by their own type with
+// a devirtualized loop, basic_function values by target manager. Groups
+// are visited in order of first insertion, calls within a group in order of
+// insertion; order across groups is not kept. Results are discarded.
+// Every callable gets the same arguments, so parameters are lvalue
+// references or copyable values (no rvalue references).
+//============================================================================
+template<class R, class... Args>
+class function_group<R(Args...)> {
+public:
+    static_assert(
+        detail::function::is_shared_args<Args...>::value,
+        "function_group passes the same arguments to every callable: "
+        "rvalue reference and move-only parameters are not supported");
+
+    function_group() = default;
+    function_group(function_group&&) noexcept = default;
+    function_group& operator=(function_group&&) noexcept = default;
+
+    template<class F>
+    void push_back(F&& f) {
+        using functor_type = typename std::decay<F>::type;
+        push_back_(
+            std::forward<F>(f), detail::function::is_function<functor_type>());
+    }
+
+    template<class F, class... A>
+    void emplace_back(A&&... args) {
+        group_of_<F>(group_type<F>::type_key())
+            .items.emplace_back(std::forward<A>(args)...);
+        ++size_;
+    }
+
+    // Call every callable with args (passed as lvalues).
+    void invoke_all(Args... args) {
+        for(auto& g : groups_)
+            g->invoke_all(args...);
+    }
+
+    void operator()(Args... args) {
+        for(auto& g : groups_)
+            g->invoke_all(args...);
+    }
+
+    size_t size() const noexcept {
+        return size_;
+    }
+
+    bool empty() const noexcept {
+        return size_ == 0;
+    }
+
+    size_t group_count() const noexcept {
+        return groups_.size();
+    }
+
+    void clear() noexcept {
+        groups_.clear();
+        size_ = 0;
+    }
+
+private:
+    template<class T>
+    using group_type = detail::function::group<T, Args...>;
+    using group_ptr = std::unique_ptr<detail::function::group_base<Args...>>;
+
+    std::vector<group_ptr> groups_;
+    size_t size_ = 0;
+
+    // Groups are few, linear lookup with the last used group first.
+    template<class T>
+    group_type<T>& group_of_(const void* key) {
+        const void* type = group_type<T>::type_key();
+        if(!groups_.empty() && groups_.back()->key == key &&
+           groups_.back()->type == type)
+            return static_cast<group_type<T>&>(*groups_.back());
+        for(auto& g : groups_) {
+            if(g->key == key && g->type == type)
+                return static_cast<group_type<T>&>(*g);
+        }
+        groups_.emplace_back(new group_type<T>(key));
+        return static_cast<group_type<T>&>(*groups_.back());
+    }
+
+    // Concrete callable.
+    template<class F>
+    void push_back_(F&& f, std::false_type /*tag*/) {
+        using functor_type = typename std::decay<F>::type;
+        group_of_<functor_type>(group_type<functor_type>::type_key())
+            .items.push_back(std::forward<F>(f));
+        ++size_;
+    }
+
+    // Type erased function, grouped by manager (target type and placement).
+    // Empty functions are skipped.
+    template<class F>
+    void push_back_(F&& f, std::true_type /*tag*/) {
+        using function_type = typename std::decay<F>::type;
+        const void* key = detail::function::function_access::manager(f);
+        if(key == nullptr)
+            return;
+        group_of_<function_type>(key).items.push_back(std::forward<F>(f));
+        ++size_;
+    }
+};
+
+} // namespace univang
@@ -0,0 +1,113 @@
+#pragma once
+// Speculative devirtualization: function checking likely target types before
+// the indirect call (inline cache with compile-time entries).
+//============================================================================
+#include "function.hpp"
+
+namespace univang {
+namespace detail {
+namespace function {
+
+template<class... Likely>
+struct hint_dispatch;
+
+template<>
+struct hint_dispatch<> {
+    template<class Function, class Call, class... A>
+    static typename Function::result_type call(
+        const Function& /*f*/, Call& fallback, A&&... args) {
+        return fallback(std::forward<A>(args)...);
+    }
+};
+
+template<class F, class... Rest>
+struct hint_dispatch<F, Rest...> {
+    template<class Function, class Call, class... A>
+    static typename Function::result_type call(
+        const Function& f, Call& fallback, A&&... args) {
+        if(function_access::holds<F>(f))
+            return function_access::call<F>(f, std::forward<A>(args)...);
+        return hint_dispatch<Rest...>::call(
+            f, fallback, std::forward<A>(args)...);
+    }
+};
+
+} // namespace function
+} // namespace detail
+
+template<class Function, class... Likely>
+class hinted_function;
+
+// Function whose call compares the target trampoline with those of the
+// Likely types (in order) and calls a matching target directly, so it can
+// be inlined; other targets take the usual indirect call:
+//   auto on_tick = [this](int t) { ... };
+//   hinted_function<function<void(int)>, decltype(on_tick)> f = on_tick;
+// Each hint costs a compare and a branch on mismatch, keep the list short.
+//============================================================================
+template<
+    class R, class... Args, size_t Size, fn_opt Options, class Storage,
+    class... Likely>
+class hinted_function<
+    basic_function<R(Args...), Size, Options, Storage>, Likely...>
+    : public basic_function<R(Args...), Size, Options, Storage> {
+public:
+    using function_type = basic_function<R(Args...), Size, Options, Storage>;
+
+    static_assert(
+        !detail::function::fn_opt_enabled(Options, fn_opt::once),
+        "call-once function is not supported");
+
+    using function_type::function_type;
+    using function_type::operator=;
+
+    hinted_function() = default;
+
+    hinted_function(const function_type& f) : function_type(f) {
+    }
+
+    hinted_function(function_type&& f) noexcept
+        : function_type(std::move(f)) {
+    }
+
+    R operator()(Args... args) {
+        function_type& self = *this;
+        return detail::function::hint_dispatch<Likely...>::call(
+            self, self, static_cast<Args&&>(args)...);
+    }
+};
+
+template<
+    class R, class... Args, size_t Size, fn_opt Options, class Storage,
+    class... Likely>
+class hinted_function<
+    basic_function<R(Args...) const, Size, Options, Storage>, Likely...>
+    : public basic_function<R(Args...) const, Size, Options, Storage> {
+public:
+    using function_type =
+        basic_function<R(Args...) const, Size, Options, Storage>;
+
+    static_assert(
+        !detail::function::fn_opt_enabled(Options, fn_opt::once),
+        "call-once function is not supported");
+
+    using function_type::function_type;
+    using function_type::operator=;
+
+    hinted_function() = default;
+
+    hinted_function(const function_type& f) : function_type(f) {
+    }
+
+    hinted_function(function_type&& f) noexcept
+        : function_type(std::move(f)) {
+    }
+
+    R operator()(Args... args) const {
+        const function_type& self = *this;
+        return detail::function::hint_dispatch<Likely...>::call(
+            self, self, static_cast<Args&&>(args)...);
+    }
+};
+
+} // namespace univang
@@ -0,0 +1,86 @@
+#pragma once
+// Huge page backed pool for long-lived function targets: dynamically stored
+// targets are packed into 2MB pages to reduce dTLB misses on table sweeps.
+//============================================================================
+#include "function_pool.hpp"
+
+#include <cstdint>
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+namespace univang {
+namespace detail {
+namespace function {
+
+// 2MB region, explicit huge page if reserved, else 2MB aligned mapping
+// advised for transparent huge pages. nullptr when mapping fails.
+struct hugepage_region {
+    constexpr static size_t size = size_t(2) << 20;
+
+    static void* allocate(size_t bytes) noexcept {
+#if defined(__linux__)
+        const int prot = PROT_READ | PROT_WRITE;
+        const int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#if defined(MAP_HUGETLB)
+        void* huge = ::mmap(nullptr, bytes, prot, flags | MAP_HUGETLB, -1, 0);
+        if(huge != MAP_FAILED)
+            return huge;
+#endif
+        // Over-map to trim to huge page alignment.
+        void* p = ::mmap(nullptr, bytes * 2, prot, flags, -1, 0);
+        if(p == MAP_FAILED)
+            return nullptr;
+        auto begin = reinterpret_cast<std::uintptr_t>(p);
+        auto aligned = (begin + bytes - 1) & ~(std::uintptr_t(bytes) - 1);
+        if(aligned != begin)
+            ::munmap(p, aligned - begin);
+        if(aligned + bytes != begin + bytes * 2) {
+            ::munmap(
+                reinterpret_cast<void*>(aligned + bytes),
+                begin + bytes - aligned);
+        }
+#if defined(MADV_HUGEPAGE)
+        ::madvise(reinterpret_cast<void*>(aligned), bytes, MADV_HUGEPAGE);
+#endif
+        return reinterpret_cast<void*>(aligned);
+#else
+        (void)bytes;
+        return nullptr;
+#endif
+    }
+};
+
+} // namespace function
+} // namespace detail
+
+// Stateless function allocator drawing from the process-wide huge page pool,
+// e.g. function<void()> f(std::allocator_arg, fn_hugepage_alloc(), lambda).
+// Large or over-aligned targets fall back to the general heap.
+struct fn_hugepage_alloc {
+    using pool_type =
+        detail::function::block_pool<detail::function::hugepage_region>;
+
+    void* allocate(size_t size, size_t align) {
+        if(!pool_type::fits(size, align))
+            return detail::function::heap_allocate(size, align);
+        return pool().allocate(size);
+    }
+
+    void deallocate(void* p, size_t size, size_t align) noexcept {
+        if(!pool_type::fits(size, align))
+            return detail::function::heap_deallocate(p, align);
+        pool().deallocate(p, size);
+    }
+
+    static pool_type& pool() {
+        return detail::function::global_pool<
+            detail::function::hugepage_region>();
+    }
+};
+
+struct fn_hugepage_storage : fn_default_storage {
+    using allocator = fn_hugepage_alloc;
+};
+
+} // namespace univang
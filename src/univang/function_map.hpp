@@ -0,0 +1,424 @@
+#pragma once
+// Key to handler maps: perfect hash over a compile-time key set and flat
+// open addressed table for run-time keys. Handlers are stored contiguously
+// (by value, targets in their local storage).
+//============================================================================
+#if __cplusplus < 201703L && (!defined(_MSVC_LANG) || _MSVC_LANG < 201703L)
+#error "function_map.hpp requires C++17 (std::string_view)"
+#endif
+
+#include "function.hpp"
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace univang {
+namespace detail {
+namespace function {
+
+inline constexpr uint64_t mix64(uint64_t x) noexcept {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    x ^= x >> 31;
+    return x;
+}
+
+inline constexpr size_t pow2_at_least(size_t n) noexcept {
+    size_t p = 1;
+    while(p < n)
+        p <<= 1;
+    return p;
+}
+
+// Constant key hash: integral and enum keys, std::string_view.
+template<class Key, class Enable = void>
+struct perfect_key;
+
+template<class Key>
+struct perfect_key<
+    Key, typename std::enable_if<
+             std::is_integral<Key>::value || std::is_enum<Key>::value>::type> {
+    static constexpr uint64_t hash(Key key) noexcept {
+        return mix64(static_cast<uint64_t>(key));
+    }
+};
+
+template<>
+struct perfect_key<std::string_view> {
+    static constexpr uint64_t hash(std::string_view key) noexcept {
+        // FNV-1a.
+        uint64_t h = 14695981039346656037ull;
+        for(char c : key)
+            h = (h ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+        return mix64(h);
+    }
+};
+
+constexpr static uint32_t perfect_max_displacement = 1u << 16;
+
+template<class Hash, class Enable = void>
+struct is_transparent_hash : std::false_type {};
+
+template<class Hash>
+struct is_transparent_hash<
+    Hash,
+    typename std::conditional<true, void, typename Hash::is_transparent>::type>
+    : std::true_type {};
+
+// Run-time key hash, applied to keys and to lookup keys.
+template<class Key, class Hash>
+struct map_hash {
+    template<class K>
+    static size_t hash(const K& key) noexcept {
+        return Hash()(key);
+    }
+};
+
+// std::hash<std::string> is not transparent, but std::hash<std::string_view>
+// hashes equal characters to the same value.
+template<>
+struct map_hash<std::string, std::hash<std::string>> {
+    static size_t hash(std::string_view key) noexcept {
+        return std::hash<std::string_view>()(key);
+    }
+};
+
+// Key other than Key accepted by find: any key with a transparent Hash,
+// anything convertible to std::string_view for std::string keys.
+template<class Key, class Hash, class K>
+struct is_map_lookup_key
+    : std::integral_constant<
+          bool,
+          !std::is_same<K, Key>::value &&
+              (is_transparent_hash<Hash>::value ||
+               (std::is_same<Key, std::string>::value &&
+                std::is_same<Hash, std::hash<std::string>>::value &&
+                std::is_convertible<const K&, std::string_view>::value))> {};
+
+} // namespace function
+} // namespace detail
+
+// Perfect hash of N keys (hash and displace): keys are split into buckets,
+// each bucket has a displacement placing its keys into free slots of a
+// table of at least 2N slots. Lookup is one key hash, two table loads and
+// one key comparison. Built by make_perfect_hash, at compile time when
+// declared constexpr.
+//============================================================================
+template<class Key, size_t N>
+struct perfect_hash {
+    static_assert(N > 0, "empty key set");
+
+    constexpr static size_t table_size =
+        detail::function::pow2_at_least(2 * N);
+    constexpr static size_t bucket_count = (N + 1) / 2;
+
+    Key keys[N] = {};
+    uint32_t displacement[bucket_count] = {};
+    uint32_t slots[table_size] = {}; // key index + 1, 0 - free
+
+    static constexpr uint64_t hash(const Key& key) noexcept {
+        return detail::function::perfect_key<Key>::hash(key);
+    }
+
+    static constexpr size_t bucket(uint64_t h) noexcept {
+        return static_cast<size_t>((h >> 32) % bucket_count);
+    }
+
+    static constexpr size_t slot(uint64_t h, uint32_t d) noexcept {
+        return static_cast<size_t>(
+            detail::function::mix64(h ^ (d * 0x9e3779b97f4a7c15ull)) &
+            (table_size - 1));
+    }
+
+    // Key index, N if key is not in the set.
+    constexpr size_t find(const Key& key) const noexcept {
+        const uint64_t h = hash(key);
+        const uint32_t i = slots[slot(h, displacement[bucket(h)])];
+        return i != 0 && keys[i - 1] == key ? i - 1 : N;
+    }
+};
+
+// constexpr auto keys = make_perfect_hash<std::string_view>({"a", "b"});
+// Duplicate keys make it fail (not a constant expression at compile time).
+template<class Key, size_t N>
+inline constexpr perfect_hash<Key, N> make_perfect_hash(const Key (&keys)[N]) {
+    using table = perfect_hash<Key, N>;
+    table t{};
+    uint64_t hashes[N] = {};
+    size_t sizes[table::bucket_count] = {};
+    for(size_t i = 0; i < N; ++i) {
+        for(size_t j = 0; j < i; ++j) {
+            if(keys[j] == keys[i])
+                throw std::invalid_argument("duplicate function_map key");
+        }
+        t.keys[i] = keys[i];
+        hashes[i] = table::hash(keys[i]);
+        ++sizes[table::bucket(hashes[i])];
+    }
+    // Largest buckets first, while the table is emptier.
+    bool placed[table::bucket_count] = {};
+    for(size_t n = 0; n < table::bucket_count; ++n) {
+        size_t b = table::bucket_count;
+        for(size_t c = 0; c < table::bucket_count; ++c) {
+            if(!placed[c] && (b == table::bucket_count || sizes[c] > sizes[b]))
+                b = c;
+        }
+        placed[b] = true;
+        if(sizes[b] == 0)
+            break;
+        for(uint32_t d = 0;; ++d) {
+            if(d == detail::function::perfect_max_displacement)
+                throw std::length_error("no perfect hash found");
+            bool fits = true;
+            for(size_t i = 0; i < N && fits; ++i) {
+                if(table::bucket(hashes[i]) != b)
+                    continue;
+                size_t s = table::slot(hashes[i], d);
+                if(t.slots[s] != 0)
+                    fits = false;
+                else
+                    t.slots[s] = static_cast<uint32_t>(i + 1);
+            }
+            if(fits) {
+                t.displacement[b] = d;
+                break;
+            }
+            // Roll back keys of the bucket placed with d.
+            for(size_t i = 0; i < N; ++i) {
+                size_t s = table::slot(hashes[i], d);
+                if(table::bucket(hashes[i]) == b && t.slots[s] == i + 1)
+                    t.slots[s] = 0;
+            }
+        }
+    }
+    return t;
+}
+
+// Handlers of a fixed key set found by perfect hash, no probing:
+//   constexpr auto msg_keys =
+//       make_perfect_hash<std::string_view>({"login", "logout", "ping"});
+//   auto handlers = make_function_map<void(message&)>(msg_keys);
+//   handlers.at("login") = [this](message& m) { ... };
+//   if(auto* h = handlers.find(m.type)) (*h)(m);
+//============================================================================
+template<class Key, class Sig, size_t N, class Function = function<Sig>>
+class static_function_map {
+public:
+    using key_type = Key;
+    using mapped_type = Function;
+
+    explicit static_function_map(const perfect_hash<Key, N>& keys)
+        : keys_(keys) {
+    }
+
+    // Handler of key, nullptr for keys out of the set.
+    Function* find(const Key& key) noexcept {
+        const size_t i = keys_.find(key);
+        return i == N ? nullptr : &handlers_[i];
+    }
+
+    const Function* find(const Key& key) const noexcept {
+        const size_t i = keys_.find(key);
+        return i == N ? nullptr : &handlers_[i];
+    }
+
+    Function& at(const Key& key) {
+        Function* f = find(key);
+        if(f == nullptr)
+            throw std::out_of_range("unknown function_map key");
+        return *f;
+    }
+
+    const Function& at(const Key& key) const {
+        const Function* f = find(key);
+        if(f == nullptr)
+            throw std::out_of_range("unknown function_map key");
+        return *f;
+    }
+
+    // Handler and key by index in the key set.
+    Function& operator[](size_t index) noexcept {
+        return handlers_[index];
+    }
+
+    const Function& operator[](size_t index) const noexcept {
+        return handlers_[index];
+    }
+
+    const Key& key(size_t index) const noexcept {
+        return keys_.keys[index];
+    }
+
+    constexpr static size_t size() noexcept {
+        return N;
+    }
+
+private:
+    perfect_hash<Key, N> keys_;
+    Function handlers_[N];
+};
+
+template<class Sig, class Function = function<Sig>, class Key, size_t N>
+inline static_function_map<Key, Sig, N, Function> make_function_map(
+    const perfect_hash<Key, N>& keys) {
+    return static_function_map<Key, Sig, N, Function>(keys);
+}
+
+// Handlers of run-time keys: flat open addressed table (linear probing,
+// at most half full) of indices into contiguous key and handler arrays.
+// Slots keep a hash tag, so other keys are rarely compared. Insertion may
+// move handlers (pointers returned by find are invalidated). Lookup by
+// std::string_view (or a literal) of std::string keys or by any key of a
+// transparent Hash does not construct a Key.
+//============================================================================
+template<
+    class Key, class Sig, class Function = function<Sig>,
+    class Hash = std::hash<Key>>
+class function_map {
+public:
+    using key_type = Key;
+    using mapped_type = Function;
+
+    function_map() = default;
+
+    Function* find(const Key& key) noexcept {
+        const size_t pos = lookup_(key);
+        return pos == npos ? nullptr : &handlers_[slots_[pos].index - 1];
+    }
+
+    const Function* find(const Key& key) const noexcept {
+        const size_t pos = lookup_(key);
+        return pos == npos ? nullptr : &handlers_[slots_[pos].index - 1];
+    }
+
+    template<
+        class K,
+        typename std::enable_if<
+            detail::function::is_map_lookup_key<Key, Hash, K>::value,
+            bool>::type = true>
+    Function* find(const K& key) noexcept {
+        const size_t pos = lookup_(key);
+        return pos == npos ? nullptr : &handlers_[slots_[pos].index - 1];
+    }
+
+    template<
+        class K,
+        typename std::enable_if<
+            detail::function::is_map_lookup_key<Key, Hash, K>::value,
+            bool>::type = true>
+    const Function* find(const K& key) const noexcept {
+        const size_t pos = lookup_(key);
+        return pos == npos ? nullptr : &handlers_[slots_[pos].index - 1];
+    }
+
+    bool contains(const Key& key) const noexcept {
+        return lookup_(key) != npos;
+    }
+
+    template<
+        class K,
+        typename std::enable_if<
+            detail::function::is_map_lookup_key<Key, Hash, K>::value,
+            bool>::type = true>
+    bool contains(const K& key) const noexcept {
+        return lookup_(key) != npos;
+    }
+
+    template<class F>
+    Function& insert_or_assign(const Key& key, F&& f) {
+        if(Function* existing = find(key)) {
+            *existing = std::forward<F>(f);
+            return *existing;
+        }
+        if((handlers_.size() + 1) * 2 > slots_.size())
+            rehash_(slots_.empty() ? 16 : slots_.size() * 2);
+        keys_.push_back(key);
+        try {
+            handlers_.emplace_back(std::forward<F>(f));
+        } catch(...) {
+            keys_.pop_back();
+            throw;
+        }
+        place_(hash_(key), static_cast<uint32_t>(handlers_.size()));
+        return handlers_.back();
+    }
+
+    void reserve(size_t count) {
+        keys_.reserve(count);
+        handlers_.reserve(count);
+        size_t size = detail::function::pow2_at_least(count * 2);
+        if(size > slots_.size())
+            rehash_(size);
+    }
+
+    size_t size() const noexcept {
+        return handlers_.size();
+    }
+
+    bool empty() const noexcept {
+        return handlers_.empty();
+    }
+
+    void clear() noexcept {
+        keys_.clear();
+        handlers_.clear();
+        for(slot& s : slots_)
+            s = slot{};
+    }
+
+private:
+    struct slot {
+        uint32_t index = 0; // handler index + 1, 0 - free
+        uint32_t tag = 0;
+    };
+
+    constexpr static size_t npos = size_t(-1);
+
+    std::vector<Key> keys_;
+    std::vector<Function> handlers_;
+    std::vector<slot> slots_;
+
+    template<class K>
+    static uint64_t hash_(const K& key) noexcept {
+        return detail::function::mix64(static_cast<uint64_t>(
+            detail::function::map_hash<Key, Hash>::hash(key)));
+    }
+
+    template<class K>
+    size_t lookup_(const K& key) const noexcept {
+        if(slots_.empty())
+            return npos;
+        const uint64_t h = hash_(key);
+        const uint32_t tag = static_cast<uint32_t>(h >> 32);
+        const size_t mask = slots_.size() - 1;
+        for(size_t pos = static_cast<size_t>(h) & mask;;
+            pos = (pos + 1) & mask) {
+            const slot& s = slots_[pos];
+            if(s.index == 0)
+                return npos;
+            if(s.tag == tag && keys_[s.index - 1] == key)
+                return pos;
+        }
+    }
+
+    void place_(uint64_t h, uint32_t index) noexcept {
+        const size_t mask = slots_.size() - 1;
+        size_t pos = static_cast<size_t>(h) & mask;
+        while(slots_[pos].index != 0)
+            pos = (pos + 1) & mask;
+        slots_[pos] = slot{index, static_cast<uint32_t>(h >> 32)};
+    }
+
+    void rehash_(size_t size) {
+        slots_.assign(size, slot{});
+        for(size_t i = 0; i < keys_.size(); ++i)
+            place_(hash_(keys_[i]), static_cast<uint32_t>(i + 1));
+    }
+};
+
+} // namespace univang
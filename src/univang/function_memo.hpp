@@ -0,0 +1,165 @@
+#pragma once
+// Memoizing function: results of a pure target are kept in a small fixed
+// capacity cache stored inline.
+//============================================================================
+#if __cplusplus < 201402L && (!defined(_MSVC_LANG) || _MSVC_LANG < 201402L)
+#error "function_memo.hpp requires C++14 (std::index_sequence)"
+#endif
+
+#include "function.hpp"
+
+#include <cstdint>
+#include <tuple>
+#include <utility>
+
+namespace univang {
+namespace detail {
+namespace function {
+
+inline size_t hash_combine(size_t seed, size_t h) noexcept {
+    return seed ^ (h + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+}
+
+template<class... Ts>
+inline size_t hash_values(const Ts&... values) {
+    size_t seed = 0;
+    size_t hashes[] = {std::hash<Ts>()(values)..., 0};
+    for(size_t i = 0; i < sizeof...(Ts); ++i)
+        seed = hash_combine(seed, hashes[i]);
+    return seed;
+}
+
+} // namespace function
+} // namespace detail
+
+template<
+    class Sig, size_t Capacity = 16, class Function = univang::function<Sig>>
+class memo_function;
+
+// Function caching results by argument values: the target is called only on
+// cache misses, so it must be pure. Arguments are hashed with std::hash and
+// compared with operator==; arguments and result are stored by value and
+// must be default constructible. The cache is open addressed: an entry
+// lives within a probe window of 8 slots from its hash, and a miss in a
+// full window evicts by CLOCK (entries hit since the last sweep get a
+// second chance). The cache is part of the object, place the object itself
+// (e.g. in an arena) to place the cache.
+//   memo_function<double(int, int), 32> price = [](int item, int qty) {...};
+//============================================================================
+template<class R, class... Args, size_t Capacity, class Function>
+class memo_function<R(Args...), Capacity, Function> {
+public:
+    static_assert(!std::is_void<R>::value, "memoized function requires result");
+    static_assert(
+        Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+        "cache capacity must be a power of 2");
+
+    using result_type = R;
+
+    memo_function() = default;
+
+    template<
+        class F,
+        typename std::enable_if<
+            !std::is_same<typename std::decay<F>::type, memo_function>::value,
+            bool>::type = true>
+    memo_function(F&& f) : fn_(std::forward<F>(f)) {
+    }
+
+    R operator()(Args... args) {
+        key_type key(args...);
+        const size_t hash = hash_(key);
+        const size_t base = hash & mask;
+        for(size_t i = 0; i < window; ++i) {
+            slot& s = slots_[(base + i) & mask];
+            if(s.used && s.hash == hash && s.key == key) {
+                s.referenced = true;
+                ++hits_;
+                return s.value;
+            }
+        }
+        ++misses_;
+        slot& s = victim_(base);
+        s.used = false;
+        s.value = fn_(static_cast<Args&&>(args)...);
+        s.key = std::move(key);
+        s.hash = hash;
+        s.referenced = false;
+        s.used = true;
+        return s.value;
+    }
+
+    explicit operator bool() const noexcept {
+        return static_cast<bool>(fn_);
+    }
+
+    // Drop cached results (e.g. when inputs of the target changed).
+    void clear() noexcept {
+        for(slot& s : slots_)
+            s.used = false;
+    }
+
+    uint64_t hits() const noexcept {
+        return hits_;
+    }
+
+    uint64_t misses() const noexcept {
+        return misses_;
+    }
+
+    void reset_stats() noexcept {
+        hits_ = 0;
+        misses_ = 0;
+    }
+
+    constexpr static size_t capacity() noexcept {
+        return Capacity;
+    }
+
+private:
+    using key_type = std::tuple<typename std::decay<Args>::type...>;
+
+    constexpr static size_t mask = Capacity - 1;
+    constexpr static size_t window = Capacity < 8 ? Capacity : 8;
+
+    struct slot {
+        size_t hash = 0;
+        key_type key;
+        R value;
+        bool used = false;
+        bool referenced = false;
+    };
+
+    Function fn_;
+    slot slots_[Capacity];
+    uint64_t hits_ = 0;
+    uint64_t misses_ = 0;
+    uint32_t clock_ = 0;
+
+    static size_t hash_(const key_type& key) {
+        return hash_(key, std::index_sequence_for<Args...>());
+    }
+
+    template<size_t... I>
+    static size_t hash_(const key_type& key, std::index_sequence<I...>) {
+        return detail::function::hash_values(std::get<I>(key)...);
+    }
+
+    // Free slot of the window, otherwise CLOCK: the hand sweeps the window
+    // clearing reference bits until an unreferenced entry is found.
+    slot& victim_(size_t base) {
+        for(size_t i = 0; i < window; ++i) {
+            slot& s = slots_[(base + i) & mask];
+            if(!s.used)
+                return s;
+        }
+        for(;;) {
+            slot& s = slots_[(base + clock_++ % window) & mask];
+            if(!s.referenced)
+                return s;
+            s.referenced = false;
+        }
+    }
+};
+
+} // namespace univang
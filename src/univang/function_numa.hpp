@@ -0,0 +1,132 @@
+#pragma once
+// NUMA-aware placement of dynamically stored function targets: cache-line
+// aligned blocks from per-node pools bound with mbind(2).
+//============================================================================
+#include "function_hugepage.hpp"
+
+#include <atomic>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace univang {
+namespace detail {
+namespace function {
+
+constexpr static int numa_max_nodes = 64;
+
+inline int numa_current_node() noexcept {
+#if defined(__linux__) && defined(SYS_getcpu)
+    unsigned cpu = 0;
+    unsigned node = 0;
+    if(::syscall(SYS_getcpu, &cpu, &node, nullptr) == 0 &&
+       node < static_cast<unsigned>(numa_max_nodes))
+        return static_cast<int>(node);
+#endif
+    return 0;
+}
+
+// Huge page region bound to a node (mbind before first touch). Binding is
+// best effort: without NUMA support the region is used as is.
+struct numa_region {
+    constexpr static size_t size = hugepage_region::size;
+
+    int node = 0;
+
+    void* allocate(size_t bytes) const noexcept {
+        void* p = hugepage_region::allocate(bytes);
+#if defined(__linux__) && defined(SYS_mbind)
+        if(p != nullptr) {
+            const int mpol_preferred = 1;
+            const int bits = static_cast<int>(sizeof(unsigned long) * 8);
+            unsigned long mask[(numa_max_nodes + bits - 1) / bits] = {};
+            mask[node / bits] = 1UL << (node % bits);
+            // The kernel reads maxnode - 1 bits of the mask.
+            ::syscall(
+                SYS_mbind, p, bytes, mpol_preferred, mask,
+                static_cast<unsigned long>(node) + 2, 0);
+        }
+#endif
+        return p;
+    }
+};
+
+using numa_pool = block_pool<numa_region, cache_line_size>;
+
+// Lazily created process-lifetime pool per node.
+inline numa_pool& numa_node_pool(int node) {
+    static std::atomic<numa_pool*> pools[numa_max_nodes];
+    numa_pool* pool = pools[node].load(std::memory_order_acquire);
+    if(pool != nullptr)
+        return *pool;
+    numa_pool* created = new numa_pool(numa_region{node});
+    if(pools[node].compare_exchange_strong(
+           pool, created, std::memory_order_acq_rel))
+        return *created;
+    delete created;
+    return *pool;
+}
+
+} // namespace function
+} // namespace detail
+
+// Function allocator placing targets on a NUMA node: given node, or node of
+// the allocating thread (any_node). Blocks are cache-line aligned and sized
+// to avoid false sharing; targets above 1KB fall back to the general heap.
+// The resolved node is kept next to the target pointer, and
+// basic_function::migrate() moves the target to the calling thread node.
+class fn_numa_alloc {
+public:
+    constexpr static int any_node = -1;
+
+    explicit fn_numa_alloc(int node = any_node) noexcept
+        : node_(
+              node >= 0 && node < detail::function::numa_max_nodes
+                  ? node
+                  : any_node) {
+    }
+
+    void* allocate(size_t size, size_t align) {
+        if(node_ == any_node)
+            node_ = detail::function::numa_current_node();
+        if(!detail::function::numa_pool::fits(size, align))
+            return detail::function::heap_allocate(size, align);
+        return detail::function::numa_node_pool(node_).allocate(size);
+    }
+
+    void deallocate(void* p, size_t size, size_t align) noexcept {
+        if(!detail::function::numa_pool::fits(size, align))
+            return detail::function::heap_deallocate(p, align);
+        detail::function::numa_node_pool(node_).deallocate(p, size);
+    }
+
+    fn_numa_alloc migration_target() const noexcept {
+        return fn_numa_alloc(detail::function::numa_current_node());
+    }
+
+    int node() const noexcept {
+        return node_;
+    }
+
+    friend bool operator==(fn_numa_alloc lhs, fn_numa_alloc rhs) noexcept {
+        return lhs.node_ == rhs.node_;
+    }
+
+    friend bool operator!=(fn_numa_alloc lhs, fn_numa_alloc rhs) noexcept {
+        return lhs.node_ != rhs.node_;
+    }
+
+private:
+    int node_;
+};
+
+template<>
+struct is_trivially_relocatable<fn_numa_alloc> : std::true_type {};
+
+// Targets placed on the node of the constructing thread.
+struct fn_numa_storage : fn_default_storage {
+    using allocator = fn_numa_alloc;
+};
+
+} // namespace univang
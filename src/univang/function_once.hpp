@@ -0,0 +1,272 @@
+#pragma once
+// Thread-safe call-once function and lazily initialized value.
+//============================================================================
+#include "function.hpp"
+
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <thread>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace univang {
+namespace detail {
+namespace function {
+
+// Once state word.
+enum once_state : uint32_t {
+    once_idle = 0,
+    once_running = 1,
+    once_waited = 2, // running, some callers sleep on the state word
+    once_done = 3,
+};
+
+constexpr static int once_spin_count = 128;
+
+inline void cpu_relax() noexcept {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_ia32_pause();
+#endif
+}
+
+// Sleep while state is old (spurious wake ups allowed): atomic wait where
+// available, futex(2) on Linux, yield otherwise.
+inline void once_wait(std::atomic<uint32_t>& state, uint32_t old) noexcept {
+#if defined(__cpp_lib_atomic_wait)
+    state.wait(old, std::memory_order_acquire);
+#elif defined(__linux__) && defined(SYS_futex)
+    const int futex_wait_private = 128;
+    ::syscall(
+        SYS_futex, reinterpret_cast<uint32_t*>(&state), futex_wait_private,
+        old, nullptr, nullptr, 0);
+#else
+    (void)state;
+    (void)old;
+    std::this_thread::yield();
+#endif
+}
+
+inline void once_wake_all(std::atomic<uint32_t>& state) noexcept {
+#if defined(__cpp_lib_atomic_wait)
+    state.notify_all();
+#elif defined(__linux__) && defined(SYS_futex)
+    const int futex_wake_private = 129;
+    ::syscall(
+        SYS_futex, reinterpret_cast<uint32_t*>(&state), futex_wake_private,
+        INT_MAX, nullptr, nullptr, 0);
+#else
+    (void)state;
+#endif
+}
+
+// Result of the call, constructed by the running caller.
+template<class R>
+class once_result {
+public:
+    template<class Function, class... Args>
+    void emplace(Function& fn, Args&&... args) {
+        ::new(&data_) R(fn(std::forward<Args>(args)...));
+    }
+
+    R& get() noexcept {
+        return *static_cast<R*>(static_cast<void*>(&data_));
+    }
+
+    void destroy() noexcept {
+        get().~R();
+    }
+
+private:
+    typename std::aligned_storage<sizeof(R), alignof(R)>::type data_;
+};
+
+// Reference result, the referred object is not owned.
+template<class R>
+class once_result<R&> {
+public:
+    template<class Function, class... Args>
+    void emplace(Function& fn, Args&&... args) {
+        value_ = std::addressof(fn(std::forward<Args>(args)...));
+    }
+
+    R& get() noexcept {
+        return *value_;
+    }
+
+    void destroy() noexcept {
+    }
+
+private:
+    R* value_ = nullptr;
+};
+
+template<>
+class once_result<void> {
+public:
+    template<class Function, class... Args>
+    void emplace(Function& fn, Args&&... args) {
+        fn(std::forward<Args>(args)...);
+    }
+
+    void get() noexcept {
+    }
+
+    void destroy() noexcept {
+    }
+};
+
+} // namespace function
+} // namespace detail
+
+template<class Sig, class Function = function<Sig, fn_opt::once>>
+class once_function_mt;
+
+// Call-once function safe for concurrent callers: one caller runs the
+// target (with its arguments), the others spin briefly and then sleep until
+// the result is ready, later calls return the cached result. The target is
+// a call-once function, released when its call returns. If the target
+// throws, the exception reaches the running caller, the target is consumed
+// and waiting or later callers get std::bad_function_call.
+//============================================================================
+template<class R, class... Args, class Function>
+class once_function_mt<R(Args...), Function> {
+public:
+    using result_type = R;
+
+    once_function_mt() noexcept = default;
+
+    template<
+        class F,
+        typename std::enable_if<
+            !std::is_same<typename std::decay<F>::type, once_function_mt>::
+                value,
+            bool>::type = true>
+    once_function_mt(F&& f) : fn_(std::forward<F>(f)) {
+    }
+
+    once_function_mt(const once_function_mt&) = delete;
+    once_function_mt& operator=(const once_function_mt&) = delete;
+
+    ~once_function_mt() {
+        if(done())
+            result_.destroy();
+    }
+
+    typename std::add_lvalue_reference<R>::type operator()(Args... args) {
+        using namespace detail::function;
+        uint32_t state = state_.load(std::memory_order_acquire);
+        while(state != once_done) {
+            if(state == once_idle) {
+                if(state_.compare_exchange_weak(
+                       state, once_running, std::memory_order_acquire))
+                    return run_(static_cast<Args&&>(args)...);
+                continue;
+            }
+            state = wait_(state);
+        }
+        return result_.get();
+    }
+
+    // Result is ready, operator() returns without waiting.
+    bool done() const noexcept {
+        return state_.load(std::memory_order_acquire) ==
+            detail::function::once_done;
+    }
+
+private:
+    std::atomic<uint32_t> state_{detail::function::once_idle};
+    Function fn_;
+    detail::function::once_result<R> result_;
+
+    typename std::add_lvalue_reference<R>::type run_(Args... args) {
+        using namespace detail::function;
+        try {
+            result_.emplace(fn_, static_cast<Args&&>(args)...);
+        } catch(...) {
+            if(state_.exchange(once_idle, std::memory_order_release) ==
+               once_waited)
+                once_wake_all(state_);
+            throw;
+        }
+        if(state_.exchange(once_done, std::memory_order_acq_rel) ==
+           once_waited)
+            once_wake_all(state_);
+        return result_.get();
+    }
+
+    // Wait for the running caller, returns the new state.
+    uint32_t wait_(uint32_t state) noexcept {
+        using namespace detail::function;
+        for(int i = 0; i < once_spin_count && state == once_running; ++i) {
+            cpu_relax();
+            state = state_.load(std::memory_order_acquire);
+        }
+        if(state == once_running &&
+           !state_.compare_exchange_strong(
+               state, once_waited, std::memory_order_acquire))
+            return state;
+        if(state == once_running || state == once_waited) {
+            once_wait(state_, once_waited);
+            state = state_.load(std::memory_order_acquire);
+        }
+        return state;
+    }
+};
+
+// Value created on first access by an initializer function, which is
+// destroyed right after (releasing its captures). Safe for concurrent
+// access:
+//   lazy<service> svc([&config] { return service(config); });
+//   svc->handle(request);
+// A reference T keeps the returned reference (e.g. an entry looked up once).
+//============================================================================
+template<class T, class Function = function<T(), fn_opt::once>>
+class lazy {
+public:
+    using value_type = typename std::remove_reference<T>::type;
+
+    template<
+        class F,
+        typename std::enable_if<
+            !std::is_same<typename std::decay<F>::type, lazy>::value,
+            bool>::type = true>
+    explicit lazy(F&& init) : init_(std::forward<F>(init)) {
+    }
+
+    T& get() {
+        return init_();
+    }
+
+    const T& get() const {
+        return init_();
+    }
+
+    T& operator*() {
+        return get();
+    }
+
+    const T& operator*() const {
+        return get();
+    }
+
+    value_type* operator->() {
+        return std::addressof(get());
+    }
+
+    const value_type* operator->() const {
+        return std::addressof(get());
+    }
+
+    // Value is created.
+    bool ready() const noexcept {
+        return init_.done();
+    }
+
+private:
+    mutable once_function_mt<T(), Function> init_;
+};
+
+} // namespace univang
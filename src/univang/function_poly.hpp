@@ -0,0 +1,408 @@
+#pragma once
+// Type erasure with a user defined set of operations: one static table per
+// target type, targets stored as by basic_function (local storage, heap or
+// storage policy allocator).
+//============================================================================
+#if __cplusplus < 201402L && (!defined(_MSVC_LANG) || _MSVC_LANG < 201402L)
+#error "function_poly.hpp requires C++14 (decltype(auto))"
+#endif
+
+#include "function.hpp"
+
+#include <tuple>
+
+namespace univang {
+
+// Operation calling the target as a function of signature Sig (optionally
+// const qualified).
+template<class Sig>
+struct poly_call;
+
+template<class R, class... Args>
+struct poly_call<R(Args...)> {
+    using signature = R(Args...);
+
+    template<class T>
+    static R call(T& target, Args... args) {
+        return target(static_cast<Args&&>(args)...);
+    }
+};
+
+template<class R, class... Args>
+struct poly_call<R(Args...) const> {
+    using signature = R(Args...) const;
+
+    template<class T>
+    static R call(const T& target, Args... args) {
+        return target(static_cast<Args&&>(args)...);
+    }
+};
+
+namespace detail {
+namespace function {
+
+// Table entry of operation Op: trampoline of Op::call for the target type.
+template<class Op, class Sig = typename Op::signature>
+struct poly_entry;
+
+template<class Op, class R, class... Args>
+struct poly_entry<Op, R(Args...)> {
+    using fn = R (*)(void*, Args...);
+    constexpr static bool is_const = false;
+
+    template<class T, class Manager>
+    static R invoke(void* data, Args... args) {
+        return Op::call(*Manager::target(data), static_cast<Args&&>(args)...);
+    }
+
+    static R bad_call(void* /*data*/, Args... /*args*/) {
+        throw std::bad_function_call();
+    }
+};
+
+template<class Op, class R, class... Args>
+struct poly_entry<Op, R(Args...) const> {
+    using fn = R (*)(void*, Args...);
+    constexpr static bool is_const = true;
+
+    template<class T, class Manager>
+    static R invoke(void* data, Args... args) {
+        const T& target = *Manager::target(data);
+        return Op::call(target, static_cast<Args&&>(args)...);
+    }
+
+    static R bad_call(void* /*data*/, Args... /*args*/) {
+        throw std::bad_function_call();
+    }
+};
+
+template<class... Ops>
+struct poly_vtable {
+    void (*manage)(exec_op, void*, void*);
+    std::tuple<typename poly_entry<Ops>::fn...> ops;
+};
+
+// Table of target T managed by Manager, one per type and placement.
+template<class T, class Manager, class... Ops>
+struct poly_vtable_for {
+    constexpr static poly_vtable<Ops...> value = {
+        &Manager::manage,
+        {&poly_entry<Ops>::template invoke<T, Manager>...}};
+};
+
+// Table of empty poly: operations throw std::bad_function_call.
+template<class... Ops>
+struct poly_empty_vtable {
+    constexpr static poly_vtable<Ops...> value = {
+        nullptr, {&poly_entry<Ops>::bad_call...}};
+};
+
+// Namespace scope definitions of the tables (their addresses are taken),
+// implicit since C++17 inline variables.
+#if !defined(__cpp_inline_variables)
+template<class T, class Manager, class... Ops>
+constexpr poly_vtable<Ops...> poly_vtable_for<T, Manager, Ops...>::value;
+
+template<class... Ops>
+constexpr poly_vtable<Ops...> poly_empty_vtable<Ops...>::value;
+#endif
+
+template<size_t Size, fn_opt Options, class Storage, class... Ops>
+class poly_data {
+public:
+    constexpr static bool is_copyable = fn_opt_enabled(Options, fn_opt::copy);
+    constexpr static bool no_alloc = no_alloc_enabled<Options, Storage>();
+
+    static_assert(sizeof...(Ops) > 0, "no operations");
+    static_assert(
+        fn_opt_enabled(Options, fn_opt::move) &&
+            (static_cast<int>(Options) &
+             ~static_cast<int>(fn_opt::copy_move | fn_opt::no_alloc)) == 0,
+        "poly supports copy_move, move and no_alloc options");
+    static_assert(
+        Storage::allow_local || !no_alloc, "storage policy allows no storage");
+
+    poly_data() noexcept : vtable_(&empty_vtable::value) {
+    }
+
+    poly_data(const poly_data& rhs) : vtable_(&empty_vtable::value) {
+        copy_from_(rhs);
+    }
+
+    poly_data(poly_data&& rhs) noexcept : vtable_(&empty_vtable::value) {
+        move_from_(rhs);
+    }
+
+    poly_data& operator=(const poly_data& rhs) {
+        if(this != &rhs) {
+            reset_();
+            copy_from_(rhs);
+        }
+        return *this;
+    }
+
+    poly_data& operator=(poly_data&& rhs) noexcept {
+        if(this != &rhs) {
+            reset_();
+            move_from_(rhs);
+        }
+        return *this;
+    }
+
+    ~poly_data() {
+        reset_();
+    }
+
+protected:
+    using vtable_type = poly_vtable<Ops...>;
+    using empty_vtable = poly_empty_vtable<Ops...>;
+    using storage_type = local_storage<Size, Storage>;
+    using allocator_type = typename Storage::allocator;
+
+    const vtable_type* vtable_;
+    storage_type data_;
+
+    void* get_data_() const noexcept {
+        return const_cast<void*>(static_cast<const void*>(&data_));
+    }
+
+    template<class Op>
+    using entry_index = type_index<Op, Ops...>;
+
+    template<class Op>
+    typename poly_entry<Op>::fn entry_() const noexcept {
+        return std::get<entry_index<Op>::value>(vtable_->ops);
+    }
+
+    // Placement as of basic_function: local if fits and can be moved
+    // without throwing.
+    template<class T>
+    struct placement {
+        constexpr static bool fit_local_storage =
+            sizeof(T) <= sizeof(storage_type) &&
+            alignof(T) <= alignof(storage_type);
+        constexpr static bool is_nothrow_movable =
+            std::is_nothrow_move_constructible<T>::value;
+        constexpr static bool use_local_storage =
+            Storage::allow_local && fit_local_storage && is_nothrow_movable;
+        static_assert(
+            !no_alloc || (fit_local_storage && is_nothrow_movable),
+            "insufficient storage size");
+
+        using tag = std::integral_constant<bool, use_local_storage>;
+    };
+
+    // The new target is constructed before the current one is destroyed:
+    // args may refer to the current target.
+    template<class T, class... A>
+    void emplace_(A&&... args) {
+        if(vtable_->manage == nullptr) {
+            construct_<T>(
+                typename placement<T>::tag(), std::forward<A>(args)...);
+            return;
+        }
+        poly_data target;
+        target.template construct_<T>(
+            typename placement<T>::tag(), std::forward<A>(args)...);
+        reset_();
+        move_from_(target);
+    }
+
+    // Construct local.
+    template<class T, class... A>
+    void construct_(std::true_type /*local*/, A&&... args) {
+        using manage = fn_manager<T, true, true, is_copyable>;
+        ::new(&data_) T(std::forward<A>(args)...);
+        vtable_ = &poly_vtable_for<T, manage, Ops...>::value;
+    }
+
+    // Construct dynamic.
+    template<class T, class... A>
+    void construct_(std::false_type /*local*/, A&&... args) {
+        construct_dynamic_<T>(
+            std::is_void<allocator_type>(), std::forward<A>(args)...);
+    }
+
+    template<class T, class... A>
+    void construct_dynamic_(std::true_type /*new_delete*/, A&&... args) {
+        static_assert(
+            sizeof(T*) <= sizeof(storage_type), "insufficient storage size");
+        using manage = fn_manager<T, false, true, is_copyable>;
+        *static_cast<T**>(get_data_()) = new T(std::forward<A>(args)...);
+        vtable_ = &poly_vtable_for<T, manage, Ops...>::value;
+    }
+
+    template<class T, class... A>
+    void construct_dynamic_(std::false_type /*new_delete*/, A&&... args) {
+        using manage = fn_manager<T, false, true, is_copyable, allocator_type>;
+        static_assert(
+            sizeof(typename manage::slot) <= sizeof(storage_type),
+            "insufficient storage size for allocator");
+        manage::create(&data_, allocator_type(), std::forward<A>(args)...);
+        vtable_ = &poly_vtable_for<T, manage, Ops...>::value;
+    }
+
+    void reset_() noexcept {
+        if(vtable_->manage == nullptr)
+            return;
+        vtable_->manage(exec_op::DESTRUCT, &data_, nullptr);
+        vtable_ = &empty_vtable::value;
+    }
+
+    void copy_from_(const poly_data& rhs) {
+        if(rhs.vtable_->manage == nullptr)
+            return;
+        rhs.vtable_->manage(exec_op::COPY, rhs.get_data_(), &data_);
+        vtable_ = rhs.vtable_;
+    }
+
+    void move_from_(poly_data& rhs) noexcept {
+        if(rhs.vtable_->manage == nullptr)
+            return;
+        rhs.vtable_->manage(exec_op::MOVE, &rhs.data_, &data_);
+        vtable_ = rhs.vtable_;
+        rhs.vtable_ = &empty_vtable::value;
+    }
+};
+
+} // namespace function
+} // namespace detail
+
+// Type erased object supporting operations Ops. Each operation is a type
+// with the operation signature and a static call on the target:
+//   struct cancel {
+//       using signature = void();
+//       template<class T>
+//       static void call(T& task) { task.cancel(); }
+//   };
+//   struct describe {
+//       using signature = std::string() const; // const target
+//       template<class T>
+//       static std::string call(const T& task) { return task.name(); }
+//   };
+//   poly<poly_call<void()>, cancel, describe> task = download{url};
+//   task.call<cancel>();
+// The object keeps a single table pointer, the table holds the manager and
+// an entry per operation. Storage is as of basic_function: Size bytes of
+// local storage, Storage policy for placement and allocator.
+//============================================================================
+template<size_t Size, fn_opt Options, class Storage, class... Ops>
+class basic_poly
+    : private detail::function::poly_data<Size, Options, Storage, Ops...>,
+      private detail::function::copy_control<
+          detail::function::fn_opt_enabled(Options, fn_opt::copy)> {
+private:
+    using base = detail::function::poly_data<Size, Options, Storage, Ops...>;
+
+    template<class T>
+    using accept_target = typename std::enable_if<
+        !std::is_same<typename std::decay<T>::type, basic_poly>::value,
+        bool>::type;
+
+    template<class Op>
+    using accept_op = typename std::enable_if<
+        (detail::function::type_index<Op, Ops...>::value < sizeof...(Ops)),
+        bool>::type;
+
+    template<class Op>
+    using accept_const_op = typename std::enable_if<
+        (detail::function::type_index<Op, Ops...>::value < sizeof...(Ops)) &&
+            detail::function::poly_entry<Op>::is_const,
+        bool>::type;
+
+public:
+    basic_poly() noexcept = default;
+    basic_poly(std::nullptr_t) noexcept {
+    }
+
+    template<class T, accept_target<T> = true>
+    basic_poly(T&& target) {
+        this->template emplace_<typename std::decay<T>::type>(
+            std::forward<T>(target));
+    }
+
+    template<class T, accept_target<T> = true>
+    basic_poly& operator=(T&& target) {
+        this->template emplace_<typename std::decay<T>::type>(
+            std::forward<T>(target));
+        return *this;
+    }
+
+    basic_poly& operator=(std::nullptr_t) noexcept {
+        this->reset_();
+        return *this;
+    }
+
+    // Construct target of type T in place.
+    template<class T, class... A>
+    void emplace(A&&... args) {
+        this->template emplace_<T>(std::forward<A>(args)...);
+    }
+
+    // Apply operation Op to the target (std::bad_function_call if empty).
+    template<class Op, class... A, accept_op<Op> = true>
+    decltype(auto) call(A&&... args) {
+        return this->template entry_<Op>()(
+            this->get_data_(), std::forward<A>(args)...);
+    }
+
+    template<class Op, class... A, accept_const_op<Op> = true>
+    decltype(auto) call(A&&... args) const {
+        return this->template entry_<Op>()(
+            this->get_data_(), std::forward<A>(args)...);
+    }
+
+    void reset() noexcept {
+        this->reset_();
+    }
+
+    explicit operator bool() const noexcept {
+        return this->vtable_->manage != nullptr;
+    }
+
+    void swap(basic_poly& rhs) noexcept {
+        basic_poly tmp = std::move(rhs);
+        rhs = std::move(*this);
+        *this = std::move(tmp);
+    }
+};
+
+// Same footprint as function: one table pointer and pointer aligned
+// storage of default_size plus a pointer.
+template<class... Ops>
+using poly = basic_poly<
+    detail::function::default_size + sizeof(void*), fn_opt::copy_move,
+    fn_aligned_storage<alignof(void*)>, Ops...>;
+
+template<size_t Size, fn_opt Options, class Storage, class... Ops>
+inline void swap(
+    basic_poly<Size, Options, Storage, Ops...>& lhs,
+    basic_poly<Size, Options, Storage, Ops...>& rhs) noexcept {
+    lhs.swap(rhs);
+}
+
+template<size_t Size, fn_opt Options, class Storage, class... Ops>
+inline bool operator==(
+    std::nullptr_t, const basic_poly<Size, Options, Storage, Ops...>& p) {
+    return !p;
+}
+
+template<size_t Size, fn_opt Options, class Storage, class... Ops>
+inline bool operator==(
+    const basic_poly<Size, Options, Storage, Ops...>& p, std::nullptr_t) {
+    return !p;
+}
+
+template<size_t Size, fn_opt Options, class Storage, class... Ops>
+inline bool operator!=(
+    std::nullptr_t, const basic_poly<Size, Options, Storage, Ops...>& p) {
+    return static_cast<bool>(p);
+}
+
+template<size_t Size, fn_opt Options, class Storage, class... Ops>
+inline bool operator!=(
+    const basic_poly<Size, Options, Storage, Ops...>& p, std::nullptr_t) {
+    return static_cast<bool>(p);
+}
+
+} // namespace univang
@@ -0,0 +1,332 @@
+#pragma once
+// Size-class block pools for dynamically stored function targets.
+//============================================================================
+#if __cplusplus < 201703L && (!defined(_MSVC_LANG) || _MSVC_LANG < 201703L)
+#error "function_pool.hpp requires C++17 (aligned operator new)"
+#endif
+
+#include "function.hpp"
+
+#include <cstdint>
+#include <mutex>
+#include <new>
+
+namespace univang {
+namespace detail {
+namespace function {
+
+// Pooled blocks are granular (16 bytes by default) up to 1KB, larger or
+// over-aligned targets go to the general heap.
+constexpr static size_t pool_granularity = 16;
+constexpr static size_t pool_max_block = 1024;
+
+inline constexpr bool pool_fits(
+    size_t size, size_t align, size_t granularity = pool_granularity) {
+    return size <= pool_max_block && align <= granularity;
+}
+
+inline constexpr size_t pool_class(
+    size_t size, size_t granularity = pool_granularity) {
+    return size == 0 ? 0 : (size - 1) / granularity;
+}
+
+inline void* heap_allocate(size_t size, size_t align) {
+    return ::operator new(size, std::align_val_t(align));
+}
+
+inline void heap_deallocate(void* p, size_t align) noexcept {
+    ::operator delete(p, std::align_val_t(align));
+}
+
+// Thread-safe pool carving blocks out of regions provided by Region:
+//   void* Region::allocate(size_t size) noexcept; // nullptr on failure
+// with Region::size and Granularity alignment. Regions are never returned,
+// freed blocks go back to per-class free lists.
+template<class Region, size_t Granularity = pool_granularity>
+class block_pool {
+public:
+    constexpr static size_t granularity = Granularity;
+    constexpr static size_t class_count = pool_max_block / Granularity;
+
+    static constexpr bool fits(size_t size, size_t align) {
+        return pool_fits(size, align, Granularity);
+    }
+
+    explicit block_pool(Region region = Region()) : region_(region) {
+    }
+
+    block_pool(const block_pool&) = delete;
+    block_pool& operator=(const block_pool&) = delete;
+
+    void* allocate(size_t size) {
+        size_t index = pool_class(size, Granularity);
+        size = (index + 1) * Granularity;
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_block* b = free_[index];
+        if(b != nullptr) {
+            free_[index] = b->next;
+            return b;
+        }
+        if(static_cast<size_t>(end_ - pos_) < size)
+            next_region_();
+        void* p = pos_;
+        pos_ += size;
+        return p;
+    }
+
+    void deallocate(void* p, size_t size) noexcept {
+        size_t index = pool_class(size, Granularity);
+        std::lock_guard<std::mutex> lock(mutex_);
+        free_[index] = ::new(p) free_block{free_[index]};
+    }
+
+    // Regions taken from Region (the others come from the general heap).
+    size_t region_count() const noexcept {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return region_count_;
+    }
+
+    size_t fallback_count() const noexcept {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return fallback_count_;
+    }
+
+private:
+    struct free_block {
+        free_block* next;
+    };
+
+    mutable std::mutex mutex_;
+    free_block* free_[class_count] = {};
+    char* pos_ = nullptr;
+    char* end_ = nullptr;
+    size_t region_count_ = 0;
+    size_t fallback_count_ = 0;
+    Region region_;
+
+    void next_region_() {
+        // Tail of the current region is lost, at most pool_max_block bytes.
+        void* p = region_.allocate(Region::size);
+        if(p != nullptr) {
+            ++region_count_;
+        } else {
+            p = heap_allocate(Region::size, Granularity);
+            ++fallback_count_;
+        }
+        pos_ = static_cast<char*>(p);
+        end_ = pos_ + Region::size;
+    }
+};
+
+// Process-lifetime pool, never destroyed: static tables may release
+// targets after static destructors ran.
+template<class Region>
+inline block_pool<Region>& global_pool() {
+    static block_pool<Region>* pool = new block_pool<Region>();
+    return *pool;
+}
+
+// Tiered storage: per-thread caches of a few fixed size classes backed by a
+// shared depot, refilled and drained in batches.
+//============================================================================
+constexpr static size_t tier_class_count = 5;
+constexpr static size_t tier_min_block = 16;
+constexpr static size_t tier_max_block =
+    tier_min_block << (tier_class_count - 1);
+constexpr static size_t tier_chunk_size = 16 * 1024;
+constexpr static uint32_t tier_batch = 32;
+constexpr static uint32_t tier_cache_limit = 8 * tier_batch;
+
+inline constexpr bool tier_fits(size_t size, size_t align) {
+    return size <= tier_max_block && align <= tier_min_block;
+}
+
+inline constexpr size_t tier_class(size_t size, size_t index = 0) {
+    return size <= (tier_min_block << index) ? index
+                                             : tier_class(size, index + 1);
+}
+
+struct tier_block {
+    tier_block* next;
+};
+
+// Free lists shared by all threads, blocks are carved from chunks which are
+// never released.
+class tier_depot {
+public:
+    static tier_depot& instance() {
+        static tier_depot* depot = new tier_depot();
+        return *depot;
+    }
+
+    // Take up to tier_batch blocks (at least one).
+    tier_block* take(size_t index, uint32_t& count) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if(free_[index] == nullptr)
+            carve_(index);
+        tier_block* head = free_[index];
+        tier_block* tail = head;
+        count = 1;
+        while(count < tier_batch && tail->next != nullptr) {
+            tail = tail->next;
+            ++count;
+        }
+        free_[index] = tail->next;
+        tail->next = nullptr;
+        return head;
+    }
+
+    // Return list of blocks ending with tail.
+    void put(size_t index, tier_block* head, tier_block* tail) noexcept {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tail->next = free_[index];
+        free_[index] = head;
+    }
+
+    // Chunks carved so far.
+    size_t chunk_count() const noexcept {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return chunk_count_;
+    }
+
+private:
+    mutable std::mutex mutex_;
+    tier_block* free_[tier_class_count] = {};
+    size_t chunk_count_ = 0;
+
+    void carve_(size_t index) {
+        const size_t block_size = tier_min_block << index;
+        char* chunk =
+            static_cast<char*>(heap_allocate(tier_chunk_size, tier_min_block));
+        ++chunk_count_;
+        for(size_t offset = tier_chunk_size; offset >= block_size;) {
+            offset -= block_size;
+            free_[index] = ::new(chunk + offset) tier_block{free_[index]};
+        }
+    }
+};
+
+// Trivially destructible, so usable by targets released after the thread
+// cache guard ran (blocks then go straight to the depot).
+struct tier_cache {
+    tier_block* free[tier_class_count];
+    uint32_t count[tier_class_count];
+    bool registered;
+    bool released;
+};
+
+inline tier_cache& local_tier_cache();
+
+// Drains the thread cache into the depot on thread exit.
+struct tier_cache_guard {
+    ~tier_cache_guard() {
+        tier_cache& cache = local_tier_cache();
+        for(size_t index = 0; index < tier_class_count; ++index) {
+            tier_block* head = cache.free[index];
+            if(head == nullptr)
+                continue;
+            tier_block* tail = head;
+            while(tail->next != nullptr)
+                tail = tail->next;
+            tier_depot::instance().put(index, head, tail);
+            cache.free[index] = nullptr;
+            cache.count[index] = 0;
+        }
+        cache.released = true;
+    }
+};
+
+inline tier_cache& local_tier_cache() {
+    static thread_local tier_cache cache;
+    return cache;
+}
+
+// Thread cache, the guard draining it is registered on first use by either
+// allocation or release (threads which only free blocks fill caches too).
+inline tier_cache& tier_thread_cache() {
+    tier_cache& cache = local_tier_cache();
+    if(!cache.registered) {
+        cache.registered = true;
+        static thread_local tier_cache_guard guard;
+        (void)guard;
+    }
+    return cache;
+}
+
+inline void* tier_allocate(size_t index) {
+    tier_cache& cache = tier_thread_cache();
+    tier_block* b = cache.free[index];
+    if(b == nullptr) {
+        if(cache.released) {
+            uint32_t count = 0;
+            b = tier_depot::instance().take(index, count);
+            if(b->next != nullptr) {
+                tier_block* tail = b->next;
+                while(tail->next != nullptr)
+                    tail = tail->next;
+                tier_depot::instance().put(index, b->next, tail);
+            }
+            return b;
+        }
+        b = tier_depot::instance().take(index, cache.count[index]);
+    }
+    cache.free[index] = b->next;
+    --cache.count[index];
+    return b;
+}
+
+inline void tier_deallocate(void* p, size_t index) noexcept {
+    tier_cache& cache = tier_thread_cache();
+    tier_block* b = ::new(p) tier_block{nullptr};
+    if(cache.released) {
+        tier_depot::instance().put(index, b, b);
+        return;
+    }
+    b->next = cache.free[index];
+    cache.free[index] = b;
+    if(++cache.count[index] < tier_cache_limit)
+        return;
+    // Keep a batch, drain the rest.
+    tier_block* tail = b;
+    for(uint32_t i = 1; i < tier_batch; ++i)
+        tail = tail->next;
+    tier_block* rest = tail->next;
+    tail->next = nullptr;
+    cache.count[index] = tier_batch;
+    tier_block* rest_tail = rest;
+    while(rest_tail->next != nullptr)
+        rest_tail = rest_tail->next;
+    tier_depot::instance().put(index, rest, rest_tail);
+}
+
+} // namespace function
+} // namespace detail
+
+// Tiered function allocator: targets not fitting local storage take a block
+// from per-thread caches of 16..256 byte classes, larger or over-aligned
+// targets go to the general heap. The tier is a function of the target size
+// and alignment, so the manager instantiated for the target type frees to
+// the right place without storing anything. Blocks may be released from any
+// thread.
+struct fn_pool_alloc {
+    void* allocate(size_t size, size_t align) {
+        if(!detail::function::tier_fits(size, align))
+            return detail::function::heap_allocate(size, align);
+        return detail::function::tier_allocate(
+            detail::function::tier_class(size));
+    }
+
+    void deallocate(void* p, size_t size, size_t align) noexcept {
+        if(!detail::function::tier_fits(size, align))
+            return detail::function::heap_deallocate(p, align);
+        detail::function::tier_deallocate(
+            p, detail::function::tier_class(size));
+    }
+};
+
+// Storage policy: function<Sig, copy_move, fn_pool_storage>.
+struct fn_pool_storage : fn_default_storage {
+    using allocator = fn_pool_alloc;
+};
+
+} // namespace univang
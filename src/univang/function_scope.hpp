@@ -0,0 +1,211 @@
+#pragma once
+// Scope exit actions without allocation: single guard over a fixed size
+// function and a stack of cleanups packed into reusable storage.
+//============================================================================
+#include "function.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+namespace univang {
+
+// Runs action on scope exit unless released:
+//   scope_exit rollback([&] { table.erase(key); });
+//   ...
+//   rollback.release(); // committed
+// The action is kept in Size bytes of local storage, never allocated.
+//============================================================================
+template<size_t Size = detail::function::default_size>
+class scope_exit {
+public:
+    template<
+        class F,
+        typename std::enable_if<
+            !std::is_same<typename std::decay<F>::type, scope_exit>::value,
+            bool>::type = true>
+    explicit scope_exit(F&& f) : fn_(std::forward<F>(f)) {
+    }
+
+    ~scope_exit() {
+        if(fn_)
+            fn_();
+    }
+
+    // Cancel the action (destroys it without running).
+    void release() noexcept {
+        fn_.reset();
+    }
+
+    // Action not released.
+    bool active() const noexcept {
+        return static_cast<bool>(fn_);
+    }
+
+private:
+    fs_function<void(), Size> fn_;
+};
+
+namespace detail {
+namespace function {
+
+inline unsigned char* align_up(unsigned char* p, size_t align) noexcept {
+    uintptr_t v = reinterpret_cast<uintptr_t>(p);
+    return reinterpret_cast<unsigned char*>((v + align - 1) & ~(align - 1));
+}
+
+// Deferred action header, the closure follows at its alignment.
+struct defer_entry {
+    void (*run)(defer_entry* entry, bool call);
+    defer_entry* prev;
+
+    template<class F>
+    static F* closure(defer_entry* entry) noexcept {
+        return reinterpret_cast<F*>(align_up(
+            reinterpret_cast<unsigned char*>(entry + 1), alignof(F)));
+    }
+
+    template<class F>
+    static void run_closure(defer_entry* entry, bool call) {
+        F* f = closure<F>(entry);
+        if(call)
+            (*f)();
+        f->~F();
+    }
+};
+
+// Storage chunk: header followed by capacity bytes.
+struct alignas(std::max_align_t) defer_chunk {
+    defer_chunk* next;
+    size_t capacity;
+    size_t used;
+
+    unsigned char* data() noexcept {
+        return reinterpret_cast<unsigned char*>(this + 1);
+    }
+};
+
+} // namespace function
+} // namespace detail
+
+// Stack of cleanup actions run in LIFO order. Closures of any size are
+// packed back to back into Capacity bytes of inline storage, overflow goes
+// to heap chunks which are kept for reuse: a stack reused across
+// iterations (run() or release() at the end of each) stops allocating once
+// it has seen its largest frame.
+//   defer_stack<> cleanup;
+//   for(auto& tx : batch) {
+//       cleanup.defer([&] { unlock(tx.row); });
+//       ...
+//       cleanup.run();
+//   }
+// Remaining actions run on destruction. Actions must not throw.
+//============================================================================
+template<size_t Capacity = 256>
+class defer_stack {
+public:
+    defer_stack() noexcept {
+        first_.header.next = nullptr;
+        first_.header.capacity = Capacity;
+        first_.header.used = 0;
+    }
+
+    defer_stack(const defer_stack&) = delete;
+    defer_stack& operator=(const defer_stack&) = delete;
+
+    ~defer_stack() {
+        run();
+        defer_chunk* c = first_.header.next;
+        while(c != nullptr) {
+            defer_chunk* next = c->next;
+            ::operator delete(c);
+            c = next;
+        }
+    }
+
+    // Add action, it runs before the ones added earlier.
+    template<class F>
+    void defer(F&& f) {
+        using functor_type = typename std::decay<F>::type;
+        const size_t size = sizeof(detail::function::defer_entry) +
+            alignof(functor_type) - 1 + sizeof(functor_type);
+        defer_chunk* c = chunk_for_(size);
+        unsigned char* p = detail::function::align_up(
+            c->data() + c->used, alignof(detail::function::defer_entry));
+        auto* entry = ::new(p) detail::function::defer_entry{
+            &detail::function::defer_entry::run_closure<functor_type>, top_};
+        functor_type* closure =
+            detail::function::defer_entry::closure<functor_type>(entry);
+        ::new(closure) functor_type(std::forward<F>(f));
+        c->used = static_cast<size_t>(
+            reinterpret_cast<unsigned char*>(closure + 1) - c->data());
+        top_ = entry;
+        ++size_;
+    }
+
+    // Run all actions (last added first), storage is kept.
+    void run() noexcept {
+        unwind_(true);
+    }
+
+    // Drop all actions without running them (e.g. on commit).
+    void release() noexcept {
+        unwind_(false);
+    }
+
+    size_t size() const noexcept {
+        return size_;
+    }
+
+    bool empty() const noexcept {
+        return size_ == 0;
+    }
+
+private:
+    using defer_chunk = detail::function::defer_chunk;
+
+    struct inline_chunk {
+        defer_chunk header;
+        alignas(std::max_align_t) unsigned char data[Capacity];
+    };
+
+    static_assert(
+        offsetof(inline_chunk, data) == sizeof(defer_chunk),
+        "chunk data must follow the header");
+
+    inline_chunk first_;
+    defer_chunk* current_ = &first_.header;
+    detail::function::defer_entry* top_ = nullptr;
+    size_t size_ = 0;
+
+    // Chunk with size bytes free (size includes alignment slack).
+    defer_chunk* chunk_for_(size_t size) {
+        const size_t slack = alignof(detail::function::defer_entry);
+        while(current_->used + slack + size > current_->capacity) {
+            if(current_->next == nullptr) {
+                size_t capacity = current_->capacity * 2;
+                if(capacity < size + slack)
+                    capacity = size + slack;
+                void* p = ::operator new(sizeof(defer_chunk) + capacity);
+                current_->next = ::new(p) defer_chunk{nullptr, capacity, 0};
+            }
+            current_ = current_->next;
+            current_->used = 0;
+        }
+        return current_;
+    }
+
+    void unwind_(bool call) noexcept {
+        while(top_ != nullptr) {
+            detail::function::defer_entry* entry = top_;
+            top_ = entry->prev;
+            entry->run(entry, call);
+        }
+        for(defer_chunk* c = &first_.header; c != nullptr; c = c->next)
+            c->used = 0;
+        current_ = &first_.header;
+        size_ = 0;
+    }
+};
+
+} // namespace univang
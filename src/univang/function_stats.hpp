@@ -0,0 +1,419 @@
+#pragma once
+// Function instrumentation: per stored type construction/copy/move/call
+// counters and heap fallbacks, per function type stored size profiles.
+// Recording is compiled in only when UNIVANG_FUNCTION_STATS is defined
+// (consistently for the whole program), otherwise snapshots are empty.
+//============================================================================
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <unordered_map>
+#include <vector>
+#if defined(__cpp_rtti) || defined(__GXX_RTTI) || defined(_CPPRTTI)
+#include <typeinfo>
+#endif
+
+namespace univang {
+
+// Statistics of one stored functor type (keyed by its manager function).
+struct fn_stats {
+    const void* key = nullptr;
+    const char* type_name = nullptr; // nullptr without RTTI
+    size_t size = 0;
+    size_t align = 0;
+    size_t constructions = 0;
+    size_t heap_fallbacks = 0;
+    size_t copies = 0;
+    size_t moves = 0;
+    size_t calls = 0;
+};
+
+// Sizes of targets stored into one basic_function instantiation.
+struct fn_size_profile {
+    const void* key = nullptr;
+    const char* type_name = nullptr; // nullptr without RTTI
+    size_t capacity = 0; // current Size
+    size_t pinned = 0; // heap stored at any Size (move may throw)
+    std::vector<std::pair<size_t, size_t>> sizes; // size -> count, ascending
+};
+
+namespace detail {
+namespace function {
+
+// Single writer (owning thread) counter, readable from other threads.
+struct stats_counter {
+    std::atomic<size_t> value{0};
+
+    void inc() noexcept {
+        value.store(
+            value.load(std::memory_order_relaxed) + 1,
+            std::memory_order_relaxed);
+    }
+    size_t get() const noexcept {
+        return value.load(std::memory_order_relaxed);
+    }
+};
+
+struct stats_entry {
+    std::atomic<const char*> type_name{nullptr};
+    std::atomic<size_t> size{0};
+    std::atomic<size_t> align{0};
+    stats_counter constructions;
+    stats_counter heap_fallbacks;
+    stats_counter copies;
+    stats_counter moves;
+    stats_counter calls;
+};
+
+struct profile_entry {
+    std::atomic<const char*> type_name{nullptr};
+    std::atomic<size_t> capacity{0};
+    stats_counter pinned;
+    std::map<size_t, stats_counter> sizes;
+};
+
+using stats_map = std::unordered_map<const void*, fn_stats>;
+using profile_map = std::unordered_map<const void*, fn_size_profile>;
+
+// Unique key per type.
+template<class T>
+struct type_key {
+    static const char id;
+};
+
+template<class T>
+const char type_key<T>::id = 0;
+
+inline void merge_stats(stats_map& dst, const void* key, const fn_stats& src) {
+    fn_stats& s = dst[key];
+    s.key = key;
+    if(s.type_name == nullptr)
+        s.type_name = src.type_name;
+    if(s.size == 0) {
+        s.size = src.size;
+        s.align = src.align;
+    }
+    s.constructions += src.constructions;
+    s.heap_fallbacks += src.heap_fallbacks;
+    s.copies += src.copies;
+    s.moves += src.moves;
+    s.calls += src.calls;
+}
+
+inline void merge_profile(
+    profile_map& dst, const void* key, const fn_size_profile& src) {
+    fn_size_profile& p = dst[key];
+    p.key = key;
+    if(p.type_name == nullptr)
+        p.type_name = src.type_name;
+    if(p.capacity == 0)
+        p.capacity = src.capacity;
+    p.pinned += src.pinned;
+    std::map<size_t, size_t> sizes(p.sizes.begin(), p.sizes.end());
+    for(auto& kv : src.sizes)
+        sizes[kv.first] += kv.second;
+    p.sizes.assign(sizes.begin(), sizes.end());
+}
+
+class stats_table;
+
+// Live per-thread tables plus totals of finished threads.
+struct stats_registry {
+    std::mutex mutex;
+    std::vector<stats_table*> tables;
+    stats_map retired;
+    profile_map retired_profiles;
+
+    static stats_registry& instance() {
+        static stats_registry registry;
+        return registry;
+    }
+};
+
+// Per-thread counters, merged into the registry on thread exit.
+class stats_table {
+public:
+    stats_table() {
+        stats_registry& registry = stats_registry::instance();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        registry.tables.push_back(this);
+    }
+
+    ~stats_table() {
+        stats_registry& registry = stats_registry::instance();
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        collect(registry.retired);
+        collect(registry.retired_profiles);
+        registry.tables.erase(std::find(
+            registry.tables.begin(), registry.tables.end(), this));
+    }
+
+    stats_table(const stats_table&) = delete;
+    stats_table& operator=(const stats_table&) = delete;
+
+    static stats_table& local() {
+        static thread_local stats_table table;
+        return table;
+    }
+
+    stats_entry& get(const void* key) {
+        if(key == last_key_)
+            return *last_entry_;
+        auto it = entries_.find(key);
+        if(it == entries_.end()) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            it = entries_.emplace(
+                std::piecewise_construct, std::forward_as_tuple(key),
+                std::forward_as_tuple()).first;
+        }
+        last_key_ = key;
+        last_entry_ = &it->second;
+        return it->second;
+    }
+
+    profile_entry& get_profile(const void* key) {
+        auto it = profiles_.find(key);
+        if(it == profiles_.end()) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            it = profiles_.emplace(
+                std::piecewise_construct, std::forward_as_tuple(key),
+                std::forward_as_tuple()).first;
+        }
+        return it->second;
+    }
+
+    stats_counter& get_size(profile_entry& e, size_t size) {
+        auto it = e.sizes.find(size);
+        if(it == e.sizes.end()) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            it = e.sizes.emplace(
+                std::piecewise_construct, std::forward_as_tuple(size),
+                std::forward_as_tuple()).first;
+        }
+        return it->second;
+    }
+
+    void collect(stats_map& dst) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for(auto& kv : entries_) {
+            const stats_entry& e = kv.second;
+            fn_stats s;
+            s.type_name = e.type_name.load(std::memory_order_relaxed);
+            s.size = e.size.load(std::memory_order_relaxed);
+            s.align = e.align.load(std::memory_order_relaxed);
+            s.constructions = e.constructions.get();
+            s.heap_fallbacks = e.heap_fallbacks.get();
+            s.copies = e.copies.get();
+            s.moves = e.moves.get();
+            s.calls = e.calls.get();
+            merge_stats(dst, kv.first, s);
+        }
+    }
+
+    void collect(profile_map& dst) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for(auto& kv : profiles_) {
+            const profile_entry& e = kv.second;
+            fn_size_profile p;
+            p.type_name = e.type_name.load(std::memory_order_relaxed);
+            p.capacity = e.capacity.load(std::memory_order_relaxed);
+            p.pinned = e.pinned.get();
+            for(auto& size : e.sizes)
+                p.sizes.emplace_back(size.first, size.second.get());
+            merge_profile(dst, kv.first, p);
+        }
+    }
+
+    // Not synchronized with the owner thread (see fn_stats_reset).
+    void reset() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for(auto& kv : profiles_) {
+            kv.second.pinned.value.store(0, std::memory_order_relaxed);
+            for(auto& size : kv.second.sizes)
+                size.second.value.store(0, std::memory_order_relaxed);
+        }
+        for(auto& kv : entries_) {
+            stats_entry& e = kv.second;
+            for(stats_counter* c :
+                {&e.constructions, &e.heap_fallbacks, &e.copies, &e.moves,
+                 &e.calls})
+                c->value.store(0, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    std::mutex mutex_; // guards entries_ insertion against collection
+    std::unordered_map<const void*, stats_entry> entries_;
+    std::unordered_map<const void*, profile_entry> profiles_;
+    const void* last_key_ = nullptr;
+    stats_entry* last_entry_ = nullptr;
+};
+
+// Hooks called by function_data.
+struct stats_recorder {
+    template<class F>
+    static void construct(const void* key, bool local) {
+        stats_entry& e = stats_table::local().get(key);
+        if(e.size.load(std::memory_order_relaxed) == 0) {
+#if defined(__cpp_rtti) || defined(__GXX_RTTI) || defined(_CPPRTTI)
+            e.type_name.store(typeid(F).name(), std::memory_order_relaxed);
+#endif
+            e.align.store(alignof(F), std::memory_order_relaxed);
+            e.size.store(sizeof(F), std::memory_order_relaxed);
+        }
+        e.constructions.inc();
+        if(!local)
+            e.heap_fallbacks.inc();
+    }
+    // Target of given size stored into Owner function type.
+    template<class Owner>
+    static void store(size_t capacity, size_t size, bool movable) {
+        stats_table& table = stats_table::local();
+        profile_entry& e = table.get_profile(&type_key<Owner>::id);
+        if(e.capacity.load(std::memory_order_relaxed) == 0) {
+#if defined(__cpp_rtti) || defined(__GXX_RTTI) || defined(_CPPRTTI)
+            e.type_name.store(typeid(Owner).name(), std::memory_order_relaxed);
+#endif
+            e.capacity.store(capacity, std::memory_order_relaxed);
+        }
+        if(movable)
+            table.get_size(e, size).inc();
+        else
+            e.pinned.inc();
+    }
+    static void copy(const void* key) {
+        stats_table::local().get(key).copies.inc();
+    }
+    static void move(const void* key) {
+        stats_table::local().get(key).moves.inc();
+    }
+    // Calls of empty functions (null manager, std::bad_function_call) are
+    // not recorded.
+    static void call(const void* key) {
+        if(key != nullptr)
+            stats_table::local().get(key).calls.inc();
+    }
+};
+
+} // namespace function
+} // namespace detail
+
+// Merge counters of all threads. Counters of running threads are
+// approximate (relaxed reads).
+inline std::vector<fn_stats> fn_stats_snapshot() {
+    using namespace detail::function;
+    stats_registry& registry = stats_registry::instance();
+    stats_map merged;
+    {
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for(auto& kv : registry.retired)
+            merge_stats(merged, kv.first, kv.second);
+        for(stats_table* table : registry.tables)
+            table->collect(merged);
+    }
+    std::vector<fn_stats> result;
+    result.reserve(merged.size());
+    for(auto& kv : merged)
+        result.push_back(kv.second);
+    // Heap fallbacks first: the allocations to look at.
+    std::sort(
+        result.begin(), result.end(), [](const fn_stats& a, const fn_stats& b) {
+            if(a.heap_fallbacks != b.heap_fallbacks)
+                return a.heap_fallbacks > b.heap_fallbacks;
+            return a.constructions > b.constructions;
+        });
+    return result;
+}
+
+// Zero all counters. Quiescent use only: counters are single writer, an
+// owner thread recording concurrently may write back its pre-reset value.
+inline void fn_stats_reset() {
+    using namespace detail::function;
+    stats_registry& registry = stats_registry::instance();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.retired.clear();
+    registry.retired_profiles.clear();
+    for(stats_table* table : registry.tables)
+        table->reset();
+}
+
+// Human readable snapshot dump.
+inline void fn_stats_report(std::ostream& os) {
+    os << "size align constructions heap_fallbacks copies moves calls type\n";
+    for(const fn_stats& s : fn_stats_snapshot()) {
+        os << s.size << ' ' << s.align << ' ' << s.constructions << ' '
+           << s.heap_fallbacks << ' ' << s.copies << ' ' << s.moves << ' '
+           << s.calls << ' ' << (s.type_name ? s.type_name : "?") << '\n';
+    }
+}
+
+// Merge stored size profiles of all threads.
+inline std::vector<fn_size_profile> fn_size_profile_snapshot() {
+    using namespace detail::function;
+    stats_registry& registry = stats_registry::instance();
+    profile_map merged;
+    {
+        std::lock_guard<std::mutex> lock(registry.mutex);
+        for(auto& kv : registry.retired_profiles)
+            merge_profile(merged, kv.first, kv.second);
+        for(stats_table* table : registry.tables)
+            table->collect(merged);
+    }
+    std::vector<fn_size_profile> result;
+    result.reserve(merged.size());
+    for(auto& kv : merged)
+        result.push_back(std::move(kv.second));
+    return result;
+}
+
+// Count of profiled targets fitting into given Size.
+inline size_t fn_size_fitting(const fn_size_profile& p, size_t size) {
+    size_t count = 0;
+    for(auto& kv : p.sizes) {
+        if(kv.first <= size)
+            count += kv.second;
+    }
+    return count;
+}
+
+// Smallest Size keeping coverage part of movable targets inline (the same
+// fit test as construct_). Never less than a pointer, needed by heap targets.
+inline size_t fn_size_recommend(
+    const fn_size_profile& p, double coverage = 0.99) {
+    size_t total = 0;
+    for(auto& kv : p.sizes)
+        total += kv.second;
+    size_t size = 0;
+    size_t count = 0;
+    for(auto& kv : p.sizes) {
+        if(static_cast<double>(count) >= coverage * static_cast<double>(total))
+            break;
+        count += kv.second;
+        size = kv.first;
+    }
+    size = (size + sizeof(void*) - 1) / sizeof(void*) * sizeof(void*);
+    return size < sizeof(void*) ? sizeof(void*) : size;
+}
+
+// Per function type recommendation dump.
+inline void fn_size_report(std::ostream& os, double coverage = 0.99) {
+    os << "size inline% recommended inline% pinned type\n";
+    for(const fn_size_profile& p : fn_size_profile_snapshot()) {
+        size_t total = p.pinned;
+        for(auto& kv : p.sizes)
+            total += kv.second;
+        if(total == 0)
+            continue;
+        size_t recommended = fn_size_recommend(p, coverage);
+        os << p.capacity << ' '
+           << 100.0 * fn_size_fitting(p, p.capacity) / total << ' '
+           << recommended << ' '
+           << 100.0 * fn_size_fitting(p, recommended) / total << ' '
+           << p.pinned << ' ' << (p.type_name ? p.type_name : "?") << '\n';
+    }
+}
+
+} // namespace univang
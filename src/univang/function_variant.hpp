@@ -0,0 +1,327 @@
+#pragma once
+// Closed-set function: target is one of the listed types, stored in place
+// and dispatched by its index instead of through per-object pointers.
+//============================================================================
+#include "function.hpp"
+
+#include <cstdint>
+#include <tuple>
+
+namespace univang {
+namespace detail {
+namespace function {
+
+template<class... Ts>
+struct all_of : std::true_type {};
+
+template<class T, class... Ts>
+struct all_of<T, Ts...>
+    : std::integral_constant<bool, T::value && all_of<Ts...>::value> {};
+
+inline constexpr size_t max_of() {
+    return 0;
+}
+
+template<class... Ts>
+inline constexpr size_t max_of(size_t v, Ts... vs) {
+    return v > max_of(vs...) ? v : max_of(vs...);
+}
+
+// Storage and lifetime of one of Fs. Operations index static tables of
+// per-alternative entry points with index_ (the empty entry last), each
+// entry calls its alternative directly, so the target is inlined into it.
+template<class... Fs>
+class variant_data {
+public:
+    static_assert(sizeof...(Fs) > 0, "no alternatives");
+    static_assert(sizeof...(Fs) < 255, "too many alternatives");
+
+    constexpr static size_t npos = sizeof...(Fs);
+    constexpr static bool is_nothrow_movable =
+        all_of<std::is_nothrow_move_constructible<Fs>...>::value;
+
+    variant_data() noexcept : index_(npos) {
+    }
+
+    variant_data(const variant_data& rhs) : index_(npos) {
+        copy_from_(rhs);
+    }
+
+    variant_data(variant_data&& rhs) noexcept(is_nothrow_movable)
+        : index_(npos) {
+        move_from_(rhs);
+    }
+
+    variant_data& operator=(const variant_data& rhs) {
+        if(this != &rhs) {
+            reset_();
+            copy_from_(rhs);
+        }
+        return *this;
+    }
+
+    variant_data& operator=(variant_data&& rhs) noexcept(is_nothrow_movable) {
+        if(this != &rhs) {
+            reset_();
+            move_from_(rhs);
+        }
+        return *this;
+    }
+
+    ~variant_data() {
+        reset_();
+    }
+
+protected:
+    template<size_t I>
+    using alternative = typename std::tuple_element<I, std::tuple<Fs...>>::type;
+
+    using storage_type = typename std::aligned_storage<
+        max_of(sizeof(Fs)...), max_of(alignof(Fs)...)>::type;
+
+    storage_type data_;
+    uint8_t index_;
+
+    void* get_data_() const noexcept {
+        return const_cast<void*>(static_cast<const void*>(&data_));
+    }
+
+    template<size_t I>
+    alternative<I>* get_() const noexcept {
+        return static_cast<alternative<I>*>(get_data_());
+    }
+
+    // The new target is constructed before the current one is destroyed:
+    // args may refer to the current target.
+    template<size_t I, class... A>
+    void emplace_(A&&... args) {
+        using target_type = alternative<I>;
+        if(index_ == npos) {
+            ::new(&data_) target_type(std::forward<A>(args)...);
+        } else {
+            target_type target(std::forward<A>(args)...);
+            reset_();
+            ::new(&data_) target_type(std::move(target));
+        }
+        index_ = static_cast<uint8_t>(I);
+    }
+
+    void reset_() noexcept {
+        using destroy_fn = void (*)(void*);
+        constexpr static destroy_fn table[] = {
+            &destroy_entry_<Fs>..., &destroy_empty_};
+        table[index_](&data_);
+        index_ = npos;
+    }
+
+private:
+    template<class F>
+    static void destroy_entry_(void* f) noexcept {
+        static_cast<F*>(f)->~F();
+    }
+
+    static void destroy_empty_(void* /*f*/) noexcept {
+    }
+
+    template<class F>
+    static void copy_entry_(void* to, const void* from) {
+        ::new(to) F(*static_cast<const F*>(from));
+    }
+
+    template<class F>
+    static void move_entry_(void* to, const void* from) {
+        ::new(to) F(std::move(*static_cast<F*>(const_cast<void*>(from))));
+    }
+
+    static void transfer_empty_(void* /*to*/, const void* /*from*/) noexcept {
+    }
+
+    void copy_from_(const variant_data& rhs) {
+        using copy_fn = void (*)(void*, const void*);
+        constexpr static copy_fn table[] = {
+            &copy_entry_<Fs>..., &transfer_empty_};
+        table[rhs.index_](&data_, &rhs.data_);
+        index_ = rhs.index_;
+    }
+
+    void move_from_(variant_data& rhs) {
+        using move_fn = void (*)(void*, const void*);
+        constexpr static move_fn table[] = {
+            &move_entry_<Fs>..., &transfer_empty_};
+        table[rhs.index_](&data_, &rhs.data_);
+        index_ = rhs.index_;
+        rhs.reset_();
+    }
+};
+
+// Const/mutable operator versions.
+template<class Sig, class... Fs>
+struct variant_call_base;
+
+template<class R, class... Args, class... Fs>
+struct variant_call_base<R(Args...), Fs...> : variant_data<Fs...> {
+    using result_type = R;
+
+    R operator()(Args... args) {
+        using call_fn = R (*)(void*, Args&...);
+        constexpr static call_fn table[] = {&call_entry_<Fs>..., &bad_call_};
+        return table[this->index_](this->get_data_(), args...);
+    }
+
+private:
+    template<class F>
+    static R call_entry_(void* f, Args&... args) {
+        return (*static_cast<F*>(f))(static_cast<Args&&>(args)...);
+    }
+
+    static R bad_call_(void* /*f*/, Args&... /*args*/) {
+        throw std::bad_function_call();
+    }
+};
+
+template<class R, class... Args, class... Fs>
+struct variant_call_base<R(Args...) const, Fs...> : variant_data<Fs...> {
+    using result_type = R;
+
+    R operator()(Args... args) const {
+        using call_fn = R (*)(const void*, Args&...);
+        constexpr static call_fn table[] = {&call_entry_<Fs>..., &bad_call_};
+        return table[this->index_](this->get_data_(), args...);
+    }
+
+private:
+    template<class F>
+    static R call_entry_(const void* f, Args&... args) {
+        return (*static_cast<const F*>(f))(static_cast<Args&&>(args)...);
+    }
+
+    static R bad_call_(const void* /*f*/, Args&... /*args*/) {
+        throw std::bad_function_call();
+    }
+};
+
+} // namespace function
+} // namespace detail
+
+// Function holding one of Fs (exact types, e.g. decltype of state machine
+// handler lambdas) in place: sizeof is the largest alternative plus an
+// index, targets are never allocated and a call is one table lookup into an
+// entry point with the target inlined. Copyable when all alternatives are.
+//   auto idle = [](event e) { ... };
+//   auto busy = [this](event e) { ... };
+//   variant_function<void(event), decltype(idle), decltype(busy)> on = idle;
+//============================================================================
+template<class Sig, class... Fs>
+class variant_function
+    : private detail::function::variant_call_base<Sig, Fs...>,
+      private detail::function::copy_control<detail::function::all_of<
+          std::is_copy_constructible<Fs>...>::value> {
+private:
+    using base = detail::function::variant_call_base<Sig, Fs...>;
+
+    template<class F>
+    using index_of =
+        detail::function::type_index<typename std::decay<F>::type, Fs...>;
+
+    template<class F>
+    using accept_function = typename std::enable_if<
+        (index_of<F>::value < sizeof...(Fs)), bool>::type;
+
+public:
+    variant_function() noexcept = default;
+    variant_function(std::nullptr_t) noexcept {
+    }
+
+    template<class F, accept_function<F> = true>
+    variant_function(F&& f) {
+        this->template emplace_<index_of<F>::value>(std::forward<F>(f));
+    }
+
+    template<class F, accept_function<F> = true>
+    variant_function& operator=(F&& f) {
+        this->template emplace_<index_of<F>::value>(std::forward<F>(f));
+        return *this;
+    }
+
+    variant_function& operator=(std::nullptr_t) noexcept {
+        this->reset_();
+        return *this;
+    }
+
+    template<class F, class... A, accept_function<F> = true>
+    F& emplace(A&&... args) {
+        this->template emplace_<index_of<F>::value>(std::forward<A>(args)...);
+        return *this->template get_<index_of<F>::value>();
+    }
+
+    using typename base::result_type;
+    using base::operator();
+
+    void reset() noexcept {
+        this->reset_();
+    }
+
+    // Index of the target type in Fs, sizeof...(Fs) when empty.
+    size_t index() const noexcept {
+        return this->index_;
+    }
+
+    template<class F, accept_function<F> = true>
+    bool holds() const noexcept {
+        return this->index_ == index_of<F>::value;
+    }
+
+    template<class F, accept_function<F> = true>
+    F* target() noexcept {
+        return holds<F>() ? this->template get_<index_of<F>::value>()
+                          : nullptr;
+    }
+
+    template<class F, accept_function<F> = true>
+    const F* target() const noexcept {
+        return holds<F>() ? this->template get_<index_of<F>::value>()
+                          : nullptr;
+    }
+
+    explicit operator bool() const noexcept {
+        return this->index_ != base::npos;
+    }
+
+    void swap(variant_function& rhs) noexcept(base::is_nothrow_movable) {
+        variant_function tmp = std::move(rhs);
+        rhs = std::move(*this);
+        *this = std::move(tmp);
+    }
+};
+
+template<class Sig, class... Fs>
+inline void swap(
+    variant_function<Sig, Fs...>& lhs, variant_function<Sig, Fs...>& rhs) {
+    lhs.swap(rhs);
+}
+
+template<class Sig, class... Fs>
+inline bool operator==(
+    std::nullptr_t, const variant_function<Sig, Fs...>& f) noexcept {
+    return !f;
+}
+
+template<class Sig, class... Fs>
+inline bool operator==(
+    const variant_function<Sig, Fs...>& f, std::nullptr_t) noexcept {
+    return !f;
+}
+
+template<class Sig, class... Fs>
+inline bool operator!=(
+    std::nullptr_t, const variant_function<Sig, Fs...>& f) noexcept {
+    return static_cast<bool>(f);
+}
+
+template<class Sig, class... Fs>
+inline bool operator!=(
+    const variant_function<Sig, Fs...>& f, std::nullptr_t) noexcept {
+    return static_cast<bool>(f);
+}
+
+} // namespace univang
@@ -0,0 +1,289 @@
+#pragma once
+// Vector of functions growing by memcpy for trivially relocatable elements.
+//============================================================================
+#if __cplusplus < 201703L && (!defined(_MSVC_LANG) || _MSVC_LANG < 201703L)
+#error "function_vector.hpp requires C++17 (aligned operator new)"
+#endif
+
+#include "function.hpp"
+
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <new>
+
+namespace univang {
+
+namespace detail {
+namespace function {
+
+// Raw element buffer, realloc-based when element alignment allows it.
+template<class T, bool Relocatable>
+struct vector_buffer {
+    constexpr static bool use_realloc =
+        Relocatable && alignof(T) <= alignof(std::max_align_t);
+
+    static T* allocate(size_t n) {
+        return allocate(n, std::integral_constant<bool, use_realloc>());
+    }
+
+    static void deallocate(T* p) noexcept {
+        deallocate(p, std::integral_constant<bool, use_realloc>());
+    }
+
+    // Grow buffer holding size elements to capacity n.
+    static T* grow(T* p, size_t size, size_t n) {
+        return grow(p, size, n, std::integral_constant<bool, use_realloc>());
+    }
+
+private:
+    static T* allocate(size_t n, std::true_type /*tag*/) {
+        void* p = std::malloc(n * sizeof(T));
+        if(p == nullptr)
+            throw std::bad_alloc();
+        return static_cast<T*>(p);
+    }
+
+    static T* allocate(size_t n, std::false_type /*tag*/) {
+        return static_cast<T*>(
+            ::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+    }
+
+    static void deallocate(T* p, std::true_type /*tag*/) noexcept {
+        std::free(p);
+    }
+
+    static void deallocate(T* p, std::false_type /*tag*/) noexcept {
+        ::operator delete(p, std::align_val_t(alignof(T)));
+    }
+
+    static T* grow(T* p, size_t /*size*/, size_t n, std::true_type /*tag*/) {
+        void* np = std::realloc(static_cast<void*>(p), n * sizeof(T));
+        if(np == nullptr)
+            throw std::bad_alloc();
+        return static_cast<T*>(np);
+    }
+
+    static T* grow(T* p, size_t size, size_t n, std::false_type /*tag*/) {
+        T* np = allocate(n, std::false_type());
+        relocate(p, size, np, std::integral_constant<bool, Relocatable>());
+        deallocate(p, std::false_type());
+        return np;
+    }
+
+    static void relocate(T* p, size_t size, T* np, std::true_type /*tag*/) {
+        if(size != 0)
+            std::memcpy(static_cast<void*>(np), p, size * sizeof(T));
+    }
+
+    static void relocate(T* p, size_t size, T* np, std::false_type /*tag*/) {
+        for(size_t i = 0; i < size; ++i) {
+            ::new(np + i) T(std::move(p[i]));
+            p[i].~T();
+        }
+    }
+};
+
+} // namespace function
+} // namespace detail
+
+// Contiguous function container. Trivially relocatable elements (see
+// fn_opt::relocatable) are relocated by realloc/memcpy instead of per-element
+// move construction. Plain function<Sig> is not trivially relocatable (its
+// local targets need not be), so function_vector<function<Sig>> moves
+// elements one by one; use a relocatable function type for the fast path.
+//============================================================================
+template<class T>
+class function_vector {
+public:
+    using value_type = T;
+    using size_type = size_t;
+    using iterator = T*;
+    using const_iterator = const T*;
+
+    constexpr static bool is_relocatable = is_trivially_relocatable<T>::value;
+
+    static_assert(
+        is_relocatable || std::is_nothrow_move_constructible<T>::value,
+        "nothrow move required");
+
+    function_vector() noexcept = default;
+
+    function_vector(std::initializer_list<T> init) {
+        reserve(init.size());
+        for(const T& value : init)
+            push_back(value);
+    }
+
+    function_vector(const function_vector& rhs) {
+        reserve(rhs.size_);
+        for(const T& value : rhs)
+            push_back(value);
+    }
+
+    function_vector(function_vector&& rhs) noexcept
+        : data_(rhs.data_), size_(rhs.size_), capacity_(rhs.capacity_) {
+        rhs.data_ = nullptr;
+        rhs.size_ = 0;
+        rhs.capacity_ = 0;
+    }
+
+    ~function_vector() {
+        clear();
+        if(data_ != nullptr)
+            buffer::deallocate(data_);
+    }
+
+    function_vector& operator=(const function_vector& rhs) {
+        if(this != &rhs) {
+            function_vector tmp(rhs);
+            swap(tmp);
+        }
+        return *this;
+    }
+
+    function_vector& operator=(function_vector&& rhs) noexcept {
+        function_vector tmp(std::move(rhs));
+        swap(tmp);
+        return *this;
+    }
+
+    void swap(function_vector& rhs) noexcept {
+        std::swap(data_, rhs.data_);
+        std::swap(size_, rhs.size_);
+        std::swap(capacity_, rhs.capacity_);
+    }
+
+    size_t size() const noexcept {
+        return size_;
+    }
+
+    size_t capacity() const noexcept {
+        return capacity_;
+    }
+
+    bool empty() const noexcept {
+        return size_ == 0;
+    }
+
+    T* data() noexcept {
+        return data_;
+    }
+
+    const T* data() const noexcept {
+        return data_;
+    }
+
+    iterator begin() noexcept {
+        return data_;
+    }
+
+    iterator end() noexcept {
+        return data_ + size_;
+    }
+
+    const_iterator begin() const noexcept {
+        return data_;
+    }
+
+    const_iterator end() const noexcept {
+        return data_ + size_;
+    }
+
+    T& operator[](size_t i) noexcept {
+        return data_[i];
+    }
+
+    const T& operator[](size_t i) const noexcept {
+        return data_[i];
+    }
+
+    T& back() noexcept {
+        return data_[size_ - 1];
+    }
+
+    const T& back() const noexcept {
+        return data_[size_ - 1];
+    }
+
+    void reserve(size_t n) {
+        if(n <= capacity_)
+            return;
+        data_ = data_ == nullptr ? buffer::allocate(n)
+                                 : buffer::grow(data_, size_, n);
+        capacity_ = n;
+    }
+
+    template<class... Args>
+    T& emplace_back(Args&&... args) {
+        if(size_ == capacity_) {
+            // Arguments may refer to elements, construct before growing.
+            T value(std::forward<Args>(args)...);
+            reserve(capacity_ == 0 ? 8 : capacity_ * 2);
+            return emplace_(std::move(value));
+        }
+        return emplace_(std::forward<Args>(args)...);
+    }
+
+    void push_back(const T& value) {
+        emplace_back(value);
+    }
+
+    void push_back(T&& value) {
+        emplace_back(std::move(value));
+    }
+
+    void pop_back() noexcept {
+        data_[--size_].~T();
+    }
+
+    // Erase element, tail is shifted down (by memmove when relocatable).
+    iterator erase(const_iterator pos) noexcept {
+        T* p = data_ + (pos - data_);
+        p->~T();
+        shift_down_(p, std::integral_constant<bool, is_relocatable>());
+        --size_;
+        return p;
+    }
+
+    void clear() noexcept {
+        while(size_ != 0)
+            pop_back();
+    }
+
+private:
+    using buffer =
+        detail::function::vector_buffer<T, is_trivially_relocatable<T>::value>;
+
+    T* data_ = nullptr;
+    size_t size_ = 0;
+    size_t capacity_ = 0;
+
+    template<class... Args>
+    T& emplace_(Args&&... args) {
+        T* p = ::new(data_ + size_) T(std::forward<Args>(args)...);
+        ++size_;
+        return *p;
+    }
+
+    void shift_down_(T* p, std::true_type /*tag*/) noexcept {
+        T* last = data_ + size_;
+        std::memmove(
+            static_cast<void*>(p), p + 1, (last - p - 1) * sizeof(T));
+    }
+
+    void shift_down_(T* p, std::false_type /*tag*/) noexcept {
+        T* last = data_ + size_;
+        for(; p + 1 != last; ++p) {
+            ::new(p) T(std::move(p[1]));
+            p[1].~T();
+        }
+    }
+};
+
+template<class T>
+inline void swap(function_vector<T>& lhs, function_vector<T>& rhs) noexcept {
+    lhs.swap(rhs);
+}
+
+} // namespace univang
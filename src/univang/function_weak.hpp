@@ -0,0 +1,183 @@
+#pragma once
+// Functions bound to a weakly owned object: calls are skipped once the
+// owner is gone, expired entries can be pruned without calling them.
+//============================================================================
+#if __cplusplus < 201402L && (!defined(_MSVC_LANG) || _MSVC_LANG < 201402L)
+#error "function_weak.hpp requires C++14 (generic lambdas)"
+#endif
+
+#include "function.hpp"
+
+#include <algorithm>
+#include <memory>
+
+namespace univang {
+
+namespace detail {
+namespace function {
+
+template<class Sig>
+struct weak_target_sig;
+
+// Targets receive the locked object pointer first.
+template<class R, class... Args>
+struct weak_target_sig<R(Args...)> {
+    using type = R(void*, Args...);
+};
+
+// Callable not using the object: drops the pointer argument.
+template<class F>
+struct weak_ignore_object {
+    F fn;
+
+    template<class... A>
+    auto operator()(void*, A&&... args)
+        -> decltype(fn(std::forward<A>(args)...)) {
+        return fn(std::forward<A>(args)...);
+    }
+};
+
+// Member function pointer alone (2 pointers with the common ABI), the
+// object comes from the locked owner.
+template<class T, class M>
+struct weak_member_call {
+    M method;
+
+    template<class... A>
+    auto operator()(void* object, A&&... args) const
+        -> decltype((static_cast<T*>(object)->*method)(
+            std::forward<A>(args)...)) {
+        return (static_cast<T*>(object)->*method)(std::forward<A>(args)...);
+    }
+};
+
+template<class F>
+struct is_weak_member_call : std::false_type {};
+
+template<class T, class M>
+struct is_weak_member_call<weak_member_call<T, M>> : std::true_type {};
+
+} // namespace function
+} // namespace detail
+
+template<
+    class Sig,
+    class Function = so_function<
+        typename detail::function::weak_target_sig<Sig>::type,
+        2 * sizeof(void*)>>
+class weak_function;
+
+// Function called while owner (weak reference to the object the target
+// uses) is alive. The owner and the object pointer are kept next to the
+// function, so expired() is a plain reference count load, no type erased
+// call, and bound members only store the member pointer. Calls of an
+// expired function do nothing and return a value initialized result, or
+// throw std::bad_function_call when R is a reference.
+//============================================================================
+template<class R, class... Args, class Function>
+class weak_function<R(Args...), Function> {
+public:
+    using result_type = R;
+
+    weak_function() noexcept = default;
+
+    // Target not using the object, e.g. a lambda capturing it.
+    template<
+        class T,
+        class F,
+        typename std::enable_if<
+            !detail::function::is_weak_member_call<
+                typename std::decay<F>::type>::value,
+            bool>::type = true>
+    weak_function(std::weak_ptr<T> owner, F&& f)
+        : owner_(std::move(owner)),
+          object_(owner_.lock().get()),
+          fn_(ignore_object<typename std::decay<F>::type>{
+              std::forward<F>(f)}) {
+    }
+
+    // Member function called on the owner.
+    template<class T, class M>
+    weak_function(
+        std::weak_ptr<T> owner, detail::function::weak_member_call<T, M> call)
+        : owner_(std::move(owner)), object_(owner_.lock().get()), fn_(call) {
+    }
+
+    bool expired() const noexcept {
+        return owner_.expired();
+    }
+
+    // Locks the owner for the duration of the call.
+    R operator()(Args... args) {
+        if(auto lock = owner_.lock())
+            return fn_(object_, static_cast<Args&&>(args)...);
+        return expired_result_(std::is_reference<R>());
+    }
+
+    // Checks the owner without locking it: for dispatch cycles during which
+    // the caller guarantees alive objects are not released (e.g. they are
+    // only released by the dispatching thread). No atomic read-modify-write.
+    R invoke_unlocked(Args... args) {
+        if(owner_.expired())
+            return expired_result_(std::is_reference<R>());
+        return fn_(object_, static_cast<Args&&>(args)...);
+    }
+
+    explicit operator bool() const noexcept {
+        return static_cast<bool>(fn_) && !owner_.expired();
+    }
+
+    void reset() noexcept {
+        owner_.reset();
+        object_ = nullptr;
+        fn_ = nullptr;
+    }
+
+private:
+    template<class F>
+    using ignore_object = detail::function::weak_ignore_object<F>;
+
+    std::weak_ptr<void> owner_;
+    void* object_ = nullptr;
+    Function fn_;
+
+    static R expired_result_(std::false_type) {
+        return R();
+    }
+
+    [[noreturn]] static R expired_result_(std::true_type) {
+        throw std::bad_function_call();
+    }
+};
+
+// Bind member function of weakly owned object:
+//   subscribers.push_back(bind_weak(std::weak_ptr<view>(v), &view::update));
+// The member pointer is the only state of the target.
+template<class T, class U, class R, class... Args>
+inline weak_function<R(Args...)> bind_weak(
+    const std::weak_ptr<T>& owner, R (U::*method)(Args...)) {
+    using call = detail::function::weak_member_call<T, R (U::*)(Args...)>;
+    return weak_function<R(Args...)>(owner, call{method});
+}
+
+template<class T, class U, class R, class... Args>
+inline weak_function<R(Args...)> bind_weak(
+    const std::weak_ptr<T>& owner, R (U::*method)(Args...) const) {
+    using call =
+        detail::function::weak_member_call<T, R (U::*)(Args...) const>;
+    return weak_function<R(Args...)>(owner, call{method});
+}
+
+// Remove expired weak functions from a sequence container, returns the
+// number of removed entries.
+template<class Container>
+inline size_t erase_expired(Container& c) {
+    auto it = std::remove_if(c.begin(), c.end(), [](const auto& f) {
+        return f.expired();
+    });
+    size_t count = static_cast<size_t>(c.end() - it);
+    c.erase(it, c.end());
+    return count;
+}
+
+} // namespace univang
@@ -0,0 +1,44 @@
+#pragma once
+// Minimal checks for the standalone tests: failures are printed and
+// counted, result() gives the exit status of the test program.
+//============================================================================
+#include <cstdio>
+
+namespace univang {
+namespace test {
+
+inline int& failures() noexcept {
+    static int count = 0;
+    return count;
+}
+
+inline void check(bool ok, const char* expr, const char* file, int line) {
+    if(ok)
+        return;
+    ++failures();
+    std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expr);
+}
+
+// Prints the test summary, 0 when all checks passed.
+inline int result(const char* name) {
+    std::printf("%s: %s\n", name, failures() == 0 ? "ok" : "FAILED");
+    return failures() == 0 ? 0 : 1;
+}
+
+} // namespace test
+} // namespace univang
+
+#define CHECK(expr)                                                          \
+    ::univang::test::check(static_cast<bool>(expr), #expr, __FILE__, __LINE__)
+
+#define CHECK_THROWS(expr, exception)                                        \
+    do {                                                                     \
+        bool thrown = false;                                                 \
+        try {                                                                \
+            (void)(expr);                                                    \
+        } catch(const exception&) {                                          \
+            thrown = true;                                                   \
+        }                                                                    \
+        ::univang::test::check(                                              \
+            thrown, #expr " throws " #exception, __FILE__, __LINE__);        \
+    } while(false)
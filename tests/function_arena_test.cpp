@@ -0,0 +1,92 @@
+// Arena placed targets and storage policies.
+//============================================================================
+#include "check.hpp"
+
+#include <univang/function_arena.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace univang;
+
+namespace {
+
+int live = 0;
+
+struct big_target {
+    char buf[100] = {};
+    std::string s = "abc";
+
+    big_target() {
+        ++live;
+    }
+    big_target(const big_target& rhs) : s(rhs.s) {
+        ++live;
+    }
+    ~big_target() {
+        --live;
+    }
+    int operator()(int x) const {
+        return x + static_cast<int>(s.size());
+    }
+};
+
+void arena_rounds() {
+    char buffer[1000];
+    fn_arena arena(buffer, sizeof(buffer), 256);
+    for(int round = 0; round < 3; ++round) {
+        std::vector<function<int(int)>> v;
+        for(int i = 0; i < 100; ++i)
+            v.emplace_back(std::allocator_arg, arena.allocator(), big_target());
+        auto c = v[0];
+        CHECK(c(1) == 4);
+        int sum = 0;
+        for(auto& f : v)
+            sum += f(1);
+        CHECK(sum == 400 && arena.used() > 0);
+        v.clear();
+        c = nullptr;
+        CHECK(live == 0);
+        arena.reset();
+    }
+}
+
+void storage_policies() {
+    struct non_copyable {
+        std::unique_ptr<int> p;
+        int operator()(int x) {
+            return x + *p;
+        }
+    };
+    function<int(int), fn_opt::copy_move, fn_shared_storage> shared =
+        non_copyable{std::make_unique<int>(5)};
+    auto shared_copy = shared;
+    CHECK(shared_copy(1) == 6 && shared(2) == 7);
+
+    function<int(int), fn_opt::copy_move, fn_heap_storage> heap = [](int x) {
+        return x * 2;
+    };
+    auto heap_copy = heap;
+    CHECK(heap_copy(3) == 6);
+
+    std::string s(200, 'x');
+    function<int(), fn_opt::copy_move, fn_arena_storage> unscoped =
+        [s, s2 = s] { return static_cast<int>(s.size() + s2.size()); };
+    CHECK(unscoped() == 400);
+    fn_arena arena;
+    {
+        fn_arena_scope scope(arena);
+        function<int(), fn_opt::copy_move, fn_arena_storage> scoped =
+            [s, s2 = s] { return static_cast<int>(s.size() + s2.size()); };
+        CHECK(scoped() == 400 && arena.used() > 0);
+    }
+}
+
+} // namespace
+
+int main() {
+    arena_rounds();
+    storage_policies();
+    return univang::test::result("function_arena");
+}
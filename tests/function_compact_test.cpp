@@ -0,0 +1,63 @@
+// compact_function: registry indexed handlers.
+//============================================================================
+#include "check.hpp"
+
+#include <univang/function_compact.hpp>
+
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace univang;
+
+namespace {
+
+void calls() {
+    static_assert(sizeof(compact_function<void()>) == 48, "");
+    static_assert(sizeof(compact_function<void(), 28>) == 32, "");
+    compact_function<int(int)> f = [](int x) { return x + 1; };
+    auto g = f;
+    CHECK(f(1) == 2 && g(2) == 3);
+
+    std::string s(100, 'y');
+    compact_function<size_t() const> h = [s, s2 = s] {
+        return s.size() + s2.size();
+    };
+    auto copy = h;
+    compact_function<size_t() const> moved = std::move(h);
+    CHECK(!h && copy() == 200 && moved() == 200);
+
+    using move_only = compact_function<
+        int(), detail::function::compact_default_size, fn_opt::move>;
+    move_only m = [p = std::make_unique<int>(3)] { return *p; };
+    static_assert(!std::is_copy_constructible<decltype(m)>::value, "");
+    auto m2 = std::move(m);
+    CHECK(m2() == 3);
+
+    compact_function<void()> e;
+    CHECK_THROWS(e(), std::bad_function_call);
+}
+
+void concurrent_registration() {
+    std::vector<std::thread> threads;
+    int results[4] = {};
+    for(int i = 0; i < 4; ++i) {
+        threads.emplace_back([i, &results] {
+            compact_function<int()> q = [i] { return i; };
+            results[i] = q();
+        });
+    }
+    for(auto& t : threads)
+        t.join();
+    for(int i = 0; i < 4; ++i)
+        CHECK(results[i] == i);
+}
+
+} // namespace
+
+int main() {
+    calls();
+    concurrent_registration();
+    return univang::test::result("function_compact");
+}
@@ -0,0 +1,80 @@
+// function_group: type grouped storage and invocation.
+//============================================================================
+#include "check.hpp"
+
+#include <univang/function_group.hpp>
+
+#include <memory>
+#include <string>
+#include <utility>
+
+using namespace univang;
+
+namespace {
+
+struct event {
+    int sum = 0;
+};
+
+struct adder {
+    int v;
+
+    void operator()(event& e) const {
+        e.sum += v;
+    }
+};
+
+void grouping() {
+    function_group<void(event&)> g;
+    for(int i = 0; i < 10; ++i) {
+        g.push_back(adder{i});
+        g.push_back([i](event& e) { e.sum += 2 * i; });
+    }
+    function<void(event&)> f = adder{100};
+    g.push_back(f);
+    g.push_back(std::move(f));
+    so_function<void(event&), 64> wide = adder{1000};
+    g.push_back(wide);
+    g.push_back(function<void(event&)>());
+    g.emplace_back<adder>(adder{5});
+    CHECK(g.size() == 24);
+    CHECK(g.group_count() == 4);
+
+    event e;
+    g(e);
+    CHECK(e.sum == 45 + 90 + 200 + 1000 + 5);
+
+    auto moved = std::move(g);
+    event e2;
+    moved.invoke_all(e2);
+    CHECK(e2.sum == e.sum);
+    moved.clear();
+    CHECK(moved.empty());
+}
+
+void mixed_arguments() {
+    // Values are copied for each callable, references are shared.
+    function_group<void(std::string, const std::string&, int&)> g;
+    auto append = [](std::string s, const std::string& t, int& n) {
+        s += t;
+        n += static_cast<int>(s.size());
+    };
+    g.push_back(append);
+    g.push_back(function<void(std::string, const std::string&, int&)>(append));
+    int n = 0;
+    g(std::string("ab"), std::string("c"), n);
+    CHECK(n == 6);
+    static_assert(
+        !detail::function::is_shared_args<std::string&&>::value, "rvalue");
+    static_assert(
+        !detail::function::is_shared_args<std::unique_ptr<int>>::value,
+        "move-only");
+}
+
+} // namespace
+
+int main() {
+    grouping();
+    mixed_arguments();
+    return univang::test::result("function_group");
+}
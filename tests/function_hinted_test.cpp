@@ -0,0 +1,45 @@
+// hinted_function: hinted and unhinted targets.
+//============================================================================
+#include "check.hpp"
+
+#include <univang/function_hinted.hpp>
+
+#include <string>
+
+using namespace univang;
+
+namespace {
+
+void dispatch() {
+    int k = 3;
+    auto add = [k](int x) { return x + k; };
+    auto twice = [](int x) { return x * 2; };
+    std::string s(100, 'z');
+    auto length = [s, s2 = s](int x) { return x + static_cast<int>(s.size()); };
+    using hinted = hinted_function<
+        function<int(int)>, decltype(add), decltype(length)>;
+
+    hinted a = add, b = twice, c = length, empty;
+    CHECK(a(1) == 4 && b(2) == 4 && c(1) == 101);
+    CHECK_THROWS(empty(1), std::bad_function_call);
+
+    function<int(int)> f = add;
+    hinted from_copy = f;
+    hinted from_move = std::move(f);
+    CHECK(from_copy(0) == 3 && from_move(0) == 3);
+    a = twice;
+    CHECK(a(5) == 10);
+
+    hinted_function<function<int(int) const>, decltype(add)> ch = add;
+    const auto& cref = ch;
+    CHECK(cref(0) == 3);
+    function<int(int)> back = c;
+    CHECK(back(0) == 100);
+}
+
+} // namespace
+
+int main() {
+    dispatch();
+    return univang::test::result("function_hinted");
+}
@@ -0,0 +1,55 @@
+// Huge page backed pool: pooled and over-aligned targets.
+//============================================================================
+#include "check.hpp"
+
+#include <univang/function_hugepage.hpp>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace univang;
+
+namespace {
+
+struct alignas(64) wide_target {
+    char c[64] = {};
+
+    int operator()(int) const {
+        return 7;
+    }
+};
+
+void pooled() {
+    std::vector<function<int(int)>> v;
+    std::string s(50, 'y');
+    for(int i = 0; i < 10000; ++i) {
+        v.emplace_back(
+            std::allocator_arg, fn_hugepage_alloc(),
+            [s, i, t = s](int x) { return x + i; });
+    }
+    v.emplace_back(std::allocator_arg, fn_hugepage_alloc(), wide_target());
+    CHECK(v[5](1) == 6 && v.back()(0) == 7);
+    CHECK(
+        fn_hugepage_alloc::pool().region_count() +
+            fn_hugepage_alloc::pool().fallback_count() >
+        0);
+
+    auto copy = v;
+    v.clear();
+    std::thread t([&copy] { copy.clear(); });
+    t.join();
+    CHECK(copy.empty());
+
+    function<int(), fn_opt::copy_move, fn_hugepage_storage> f = [s, s2 = s] {
+        return static_cast<int>(s.size() + s2.size());
+    };
+    CHECK(f() == 100);
+}
+
+} // namespace
+
+int main() {
+    pooled();
+    return univang::test::result("function_hugepage");
+}
@@ -0,0 +1,78 @@
+// Perfect hash and flat function maps.
+//============================================================================
+#include "check.hpp"
+
+#include <univang/function_map.hpp>
+
+#include <string>
+
+using namespace univang;
+
+namespace {
+
+struct message {
+    std::string_view type;
+    int v;
+};
+
+enum class op { a = 3, b = 100, c = 7 };
+
+constexpr auto msg_keys = make_perfect_hash<std::string_view>(
+    {"login", "logout", "ping", "pong", "subscribe", "unsubscribe", "data",
+     "ack", "nack", "heartbeat"});
+static_assert(msg_keys.find("ping") == 2 && msg_keys.find("zzz") == 10, "");
+
+constexpr auto op_keys = make_perfect_hash<op>({op::a, op::b, op::c});
+
+void static_map() {
+    int total = 0;
+    auto handlers = make_function_map<void(message&)>(msg_keys);
+    handlers.at("login") = [&total](message& m) { total += m.v; };
+    handlers.at("data") = [&total](message& m) { total += 10 * m.v; };
+    message messages[] = {{"login", 1}, {"data", 2}, {"bogus", 5}};
+    for(message& m : messages) {
+        if(auto* h = handlers.find(m.type)) {
+            if(*h)
+                (*h)(m);
+        }
+    }
+    CHECK(total == 21);
+    CHECK_THROWS(handlers.at("x"), std::out_of_range);
+    for(size_t i = 0; i < handlers.size(); ++i)
+        CHECK(handlers.find(handlers.key(i)) == &handlers[i]);
+    CHECK(op_keys.find(op::b) == 1 && op_keys.find(op(5)) == 3);
+}
+
+void runtime_map() {
+    function_map<std::string, int(int)> map;
+    for(int i = 0; i < 1000; ++i) {
+        map.insert_or_assign(
+            "k" + std::to_string(i), [i](int v) { return v + i; });
+    }
+    CHECK(map.size() == 1000);
+    for(int i = 0; i < 1000; ++i)
+        CHECK((*map.find("k" + std::to_string(i)))(1) == i + 1);
+    CHECK(!map.find(std::string("nope")) && map.contains(std::string("k5")));
+
+    // Lookup by string_view and literal, no std::string built.
+    CHECK(map.find("k7") != nullptr && (*map.find("k7"))(0) == 7);
+    CHECK(map.contains(std::string_view("k999")) && !map.contains("k1000"));
+
+    map.insert_or_assign("k5", [](int) { return -1; });
+    CHECK((*map.find("k5"))(0) == -1 && map.size() == 1000);
+    map.clear();
+    CHECK(map.empty() && !map.find("k1"));
+
+    function_map<int, int()> ints;
+    ints.reserve(10);
+    ints.insert_or_assign(4, [] { return 4; });
+    CHECK((*ints.find(4))() == 4 && !ints.find(5));
+}
+
+} // namespace
+
+int main() {
+    static_map();
+    runtime_map();
+    return univang::test::result("function_map");
+}
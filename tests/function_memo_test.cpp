@@ -0,0 +1,45 @@
+// memo_function: cached results and eviction.
+//============================================================================
+#include "check.hpp"
+
+#include <univang/function_memo.hpp>
+
+#include <string>
+
+using namespace univang;
+
+namespace {
+
+void cache() {
+    int calls = 0;
+    memo_function<double(int, const std::string&), 16> price =
+        [&calls](int q, const std::string& s) {
+            ++calls;
+            return q * static_cast<double>(s.size());
+        };
+    std::string apple = "apple", kiwi = "kiwi";
+    for(int i = 0; i < 100; ++i) {
+        CHECK(price(i % 3, apple) == (i % 3) * 5.0);
+        CHECK(price(2, kiwi) == 8.0);
+    }
+    CHECK(calls == 4 && price.misses() == 4 && price.hits() == 196);
+
+    // Evictions keep results correct.
+    for(int i = 0; i < 1000; ++i)
+        price(i, apple);
+    CHECK(price(999, apple) == 999 * 5.0);
+    price.clear();
+    calls = 0;
+    price(1, apple);
+    CHECK(calls == 1);
+
+    memo_function<int(int)> empty;
+    CHECK(!empty);
+}
+
+} // namespace
+
+int main() {
+    cache();
+    return univang::test::result("function_memo");
+}
@@ -0,0 +1,57 @@
+// NUMA node allocator and target migration.
+//============================================================================
+#include "check.hpp"
+
+#include <univang/function_numa.hpp>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace univang;
+
+namespace {
+
+void migrate() {
+    std::string s(50, 'y');
+    std::vector<function<int(int)>> v;
+    for(int i = 0; i < 1000; ++i) {
+        v.emplace_back(
+            std::allocator_arg, fn_numa_alloc(),
+            [s, i, t = s](int x) { return x + i; });
+    }
+    v.emplace_back(
+        std::allocator_arg, fn_numa_alloc(0),
+        [s, t = s](int x) { return x + 1000; });
+
+    auto c = v[3];
+    c.migrate();
+    CHECK(c(1) == 4);
+    std::thread t([&v] {
+        for(auto& f : v)
+            f.migrate();
+    });
+    t.join();
+    long sum = 0;
+    for(auto& f : v)
+        sum += f(1);
+    CHECK(sum == 1001L * 1000 / 2 + 1001);
+
+    // Targets not placed by an allocator stay where they are.
+    function<int(int)> plain = [](int x) { return x; };
+    plain.migrate();
+    CHECK(plain(2) == 2);
+
+    function<int(), fn_opt::copy_move, fn_numa_storage> n = [s, s2 = s] {
+        return static_cast<int>(s.size() + s2.size());
+    };
+    n.migrate();
+    CHECK(n() == 100);
+}
+
+} // namespace
+
+int main() {
+    migrate();
+    return univang::test::result("function_numa");
+}
@@ -0,0 +1,88 @@
+// once_function_mt and lazy under concurrent callers.
+//============================================================================
+#include "check.hpp"
+
+#include <univang/function_once.hpp>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace univang;
+
+namespace {
+
+void racing_callers() {
+    for(int round = 0; round < 20; ++round) {
+        std::atomic<int> runs{0};
+        std::string capture(64, 'c');
+        once_function_mt<int(int)> once = [capture, &runs](int v) {
+            ++runs;
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            return v + static_cast<int>(capture.size());
+        };
+        std::atomic<int> sum{0};
+        std::vector<std::thread> threads;
+        for(int i = 0; i < 8; ++i)
+            threads.emplace_back([&] { sum += once(1); });
+        for(auto& t : threads)
+            t.join();
+        CHECK(runs == 1 && sum == 8 * 65 && once.done());
+    }
+}
+
+struct service {
+    std::string name;
+    int n = 0;
+};
+
+void lazy_value() {
+    int runs = 0;
+    lazy<service> svc([&runs] {
+        ++runs;
+        return service{"db"};
+    });
+    CHECK(!svc.ready());
+    std::atomic<int> found{0};
+    std::vector<std::thread> threads;
+    for(int i = 0; i < 8; ++i)
+        threads.emplace_back([&] { found += svc->name == "db"; });
+    for(auto& t : threads)
+        t.join();
+    ++svc->n;
+    CHECK(found == 8 && (*svc).n == 1 && runs == 1 && svc.ready());
+}
+
+void reference_result() {
+    service registry[2] = {{"a"}, {"b"}};
+    int lookups = 0;
+    lazy<service&> entry([&]() -> service& {
+        ++lookups;
+        return registry[1];
+    });
+    entry->n = 3;
+    CHECK(&*entry == &registry[1] && registry[1].n == 3 && lookups == 1);
+
+    once_function_mt<const service&()> first = [&]() -> const service& {
+        return registry[0];
+    };
+    CHECK(&first() == &registry[0] && &first() == &registry[0]);
+}
+
+void throwing_target() {
+    once_function_mt<int()> thrower = []() -> int { throw 1; };
+    CHECK_THROWS(thrower(), int);
+    CHECK_THROWS(thrower(), std::bad_function_call);
+    CHECK(!thrower.done());
+}
+
+} // namespace
+
+int main() {
+    racing_callers();
+    lazy_value();
+    reference_result();
+    throwing_target();
+    return univang::test::result("function_once");
+}
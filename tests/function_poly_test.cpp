@@ -0,0 +1,127 @@
+// poly: user defined operations over erased targets.
+//============================================================================
+#include "check.hpp"
+
+#include <univang/function_poly.hpp>
+
+#include <memory>
+#include <string>
+
+using namespace univang;
+
+namespace {
+
+struct cancel {
+    using signature = void();
+
+    template<class T>
+    static void call(T& t) {
+        t.cancel();
+    }
+};
+
+struct describe {
+    using signature = std::string() const;
+
+    template<class T>
+    static std::string call(const T& t) {
+        return t.name();
+    }
+};
+
+struct small_task {
+    int n = 0;
+
+    void operator()() {
+        ++n;
+    }
+    void cancel() {
+        n = -1;
+    }
+    std::string name() const {
+        return "small" + std::to_string(n);
+    }
+};
+
+struct big_task {
+    std::string a = "big", b, c, d;
+
+    void operator()() {
+        a += "!";
+    }
+    void cancel() {
+        a = "cancelled";
+    }
+    std::string name() const {
+        return a;
+    }
+};
+
+struct move_only_task {
+    std::unique_ptr<int> p = std::make_unique<int>(5);
+
+    void cancel() {
+    }
+    std::string name() const {
+        return std::to_string(*p);
+    }
+};
+
+using task = poly<poly_call<void()>, cancel, describe>;
+
+// Reference to the target, for targets of type big_task only.
+struct self {
+    using signature = big_task&();
+
+    static big_task& call(big_task& t) {
+        return t;
+    }
+};
+
+void operations() {
+    static_assert(sizeof(task) == sizeof(function<void()>), "");
+    task t = small_task();
+    t.call<poly_call<void()>>();
+    t.call<poly_call<void()>>();
+    CHECK(t.call<describe>() == "small2");
+    task copy = t;
+    t.call<cancel>();
+    CHECK(copy.call<describe>() == "small2" && t.call<describe>() == "small-1");
+
+    task b = big_task();
+    b.call<poly_call<void()>>();
+    task c = b;
+    c.call<cancel>();
+    CHECK(c.call<describe>() == "cancelled" && b.call<describe>() == "big!");
+    const task& cb = b;
+    CHECK(cb.call<describe>() == "big!");
+    task m = std::move(b);
+    CHECK(!b && m.call<describe>() == "big!");
+
+    // Assigning the current target to itself.
+    poly<self, describe> s = big_task();
+    s = s.call<self>();
+    CHECK(s.call<describe>() == "big");
+    s.emplace<big_task>(s.call<self>());
+    CHECK(s.call<describe>() == "big");
+
+    task e;
+    CHECK(e == nullptr);
+    CHECK_THROWS(e.call<cancel>(), std::bad_function_call);
+}
+
+void move_only() {
+    basic_poly<16, fn_opt::move, fn_default_storage, describe, cancel> m =
+        move_only_task();
+    static_assert(!std::is_copy_constructible<decltype(m)>::value, "");
+    auto moved = std::move(m);
+    CHECK(moved.call<describe>() == "5");
+}
+
+} // namespace
+
+int main() {
+    operations();
+    move_only();
+    return univang::test::result("function_poly");
+}
@@ -0,0 +1,95 @@
+// Tiered pool allocator: size classes, cross-thread release.
+//============================================================================
+#include "check.hpp"
+
+#include <univang/function_pool.hpp>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace univang;
+
+namespace {
+
+void size_classes() {
+    std::string s(50, 'y');
+    std::vector<function<int(int)>> v;
+    long expected = 0;
+    for(int i = 0; i < 3000; ++i) {
+        if(i % 3 == 0) {
+            v.emplace_back(
+                std::allocator_arg, fn_pool_alloc(),
+                [s, i](int x) { return x + i; });
+        } else if(i % 3 == 1) {
+            v.emplace_back(
+                std::allocator_arg, fn_pool_alloc(),
+                [s, i, a = s, b = s, c = s](int x) { return x + i; });
+        } else {
+            v.emplace_back(
+                std::allocator_arg, fn_pool_alloc(),
+                [s, i, a = s, b = s, c = s, d = s, e = s, f = s, g = s](
+                    int x) { return x + i; });
+        }
+        expected += 1 + i;
+    }
+    long sum = 0;
+    for(auto& f : v)
+        sum += f(1);
+    CHECK(sum == expected);
+
+    // Released by other threads.
+    std::vector<std::thread> threads;
+    for(size_t t = 0; t < 4; ++t) {
+        threads.emplace_back([&v, t] {
+            for(size_t i = t; i < v.size(); i += 4)
+                v[i] = nullptr;
+        });
+    }
+    for(auto& t : threads)
+        t.join();
+    for(auto& f : v)
+        CHECK(!f);
+}
+
+// One thread allocates, short-lived threads free: their caches go back to
+// the depot on exit, so the depot stops carving chunks.
+void producer_consumer() {
+    using pooled = function<int(), fn_opt::copy_move, fn_pool_storage>;
+    auto depot_chunks = [] {
+        return detail::function::tier_depot::instance().chunk_count();
+    };
+    size_t warm = 0;
+    for(int round = 0; round < 200; ++round) {
+        std::vector<pooled> produced;
+        for(int i = 0; i < 200; ++i) {
+            long a = i, b = 2 * i, c = 3 * i, d = 4 * i, e = 5 * i;
+            produced.emplace_back([a, b, c, d, e] {
+                return static_cast<int>(a + b + c + d + e);
+            });
+        }
+        std::thread consumer([&produced] { produced.clear(); });
+        consumer.join();
+        if(round == 10)
+            warm = depot_chunks();
+    }
+    CHECK(depot_chunks() <= warm + 1);
+}
+
+void storage_policy() {
+    std::string s(200, 'x');
+    function<int(), fn_opt::copy_move, fn_pool_storage> p = [s, s2 = s] {
+        return static_cast<int>(s.size() + s2.size());
+    };
+    auto copy = p;
+    CHECK(copy() == 400 && p() == 400);
+}
+
+} // namespace
+
+int main() {
+    size_classes();
+    producer_consumer();
+    storage_policy();
+    return univang::test::result("function_pool");
+}
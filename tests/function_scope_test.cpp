@@ -0,0 +1,100 @@
+// scope_exit and defer_stack: order, release and storage reuse.
+//============================================================================
+#include "check.hpp"
+
+#include <univang/function_scope.hpp>
+
+#include <array>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+namespace {
+
+size_t allocations = 0;
+
+} // namespace
+
+void* operator new(size_t size) {
+    ++allocations;
+    if(void* p = std::malloc(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+using namespace univang;
+
+namespace {
+
+struct alignas(64) wide {
+    int v;
+};
+
+void guard() {
+    std::vector<int> log;
+    {
+        scope_exit g([&log] { log.push_back(1); });
+    }
+    {
+        scope_exit g([&log] { log.push_back(2); });
+        CHECK(g.active());
+        g.release();
+        CHECK(!g.active());
+    }
+    CHECK(log.size() == 1 && log[0] == 1);
+}
+
+void stack_reuse() {
+    std::vector<int> log;
+    log.reserve(100);
+    defer_stack<128> cleanup;
+    size_t steady = 0;
+    for(int iteration = 0; iteration < 5; ++iteration) {
+        for(int i = 0; i < 20; ++i) {
+            if(i % 5 == 0) {
+                wide w{i};
+                cleanup.defer([&log, w] { log.push_back(w.v); });
+            } else {
+                cleanup.defer([&log, i, pad = std::array<char, 40>()] {
+                    (void)pad;
+                    log.push_back(i);
+                });
+            }
+        }
+        CHECK(cleanup.size() == 20);
+        cleanup.run();
+        for(int i = 0; i < 20; ++i)
+            CHECK(log[i] == 19 - i);
+        log.clear();
+        if(iteration == 1)
+            steady = allocations;
+    }
+    CHECK(allocations == steady);
+
+    cleanup.defer([&log] { log.push_back(7); });
+    cleanup.release();
+    CHECK(log.empty() && cleanup.empty());
+    {
+        defer_stack<> d;
+        std::string s(100, 'y');
+        d.defer([s, &log] { log.push_back(static_cast<int>(s.size())); });
+    }
+    CHECK(log.size() == 1 && log[0] == 100);
+}
+
+} // namespace
+
+int main() {
+    guard();
+    stack_reuse();
+    return univang::test::result("function_scope");
+}
@@ -0,0 +1,80 @@
+// Function statistics and stored size profiles.
+//============================================================================
+#define UNIVANG_FUNCTION_STATS
+#include "check.hpp"
+
+#include <univang/function.hpp>
+#include <univang/function_stats.hpp>
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace univang;
+
+namespace {
+
+struct big_target {
+    std::string s = std::string(100, 'x');
+    long pad[8] = {};
+
+    int operator()(int x) const {
+        return x + static_cast<int>(s.size());
+    }
+};
+
+const fn_stats* find_stats(const std::vector<fn_stats>& stats, size_t size) {
+    auto it = std::find_if(
+        stats.begin(), stats.end(),
+        [size](const fn_stats& s) { return s.size == size; });
+    return it == stats.end() ? nullptr : &*it;
+}
+
+void counters() {
+    fn_stats_reset();
+    function<int(int)> a = big_target();
+    std::thread t([&a] {
+        for(int i = 0; i < 10; ++i) {
+            auto c = a;
+            c(1);
+        }
+    });
+    t.join();
+    auto snapshot = fn_stats_snapshot();
+    const fn_stats* s = find_stats(snapshot, sizeof(big_target));
+    CHECK(s != nullptr);
+    if(s != nullptr) {
+        CHECK(s->heap_fallbacks >= 1 && s->copies >= 10 && s->calls >= 10);
+    }
+}
+
+void empty_calls() {
+    fn_stats_reset();
+    function<int(int)> empty;
+    CHECK_THROWS(empty(1), std::bad_function_call);
+    for(const fn_stats& s : fn_stats_snapshot())
+        CHECK(s.key != nullptr);
+}
+
+void size_profile() {
+    std::vector<function<int(int)>> v;
+    for(int i = 0; i < 100; ++i)
+        v.push_back([i](int x) { return x + i; });
+    bool found = false;
+    for(const fn_size_profile& p : fn_size_profile_snapshot()) {
+        if(p.capacity == detail::function::default_size &&
+           fn_size_fitting(p, p.capacity) >= 100)
+            found = true;
+    }
+    CHECK(found);
+}
+
+} // namespace
+
+int main() {
+    counters();
+    empty_calls();
+    size_profile();
+    return univang::test::result("function_stats");
+}
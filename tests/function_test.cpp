@@ -0,0 +1,260 @@
+// Basic function features: relocation, exact fit and cache line sizes,
+// batch calls, constant initialization, comparison, C callbacks and
+// adopted owning pointers.
+//============================================================================
+#include "check.hpp"
+
+#include <univang/function.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+using namespace univang;
+
+namespace {
+
+int twice(int x) {
+    return 2 * x;
+}
+
+void notify(int) {
+}
+
+void notify_other(int) {
+}
+
+int plus_context(void* context, int v) {
+    return *static_cast<int*>(context) + v;
+}
+
+void relocatable() {
+    using function_type =
+        function<int(int), fn_opt::copy_move | fn_opt::relocatable>;
+    static_assert(is_trivially_relocatable<function_type>::value, "");
+    static_assert(!is_trivially_relocatable<function<int(int)>>::value, "");
+
+    std::string s(100, 'x');
+    function_type a = [s](int) { return static_cast<int>(s.size()); };
+    function_type b = std::move(a);
+    CHECK(!a && b(0) == 100);
+}
+
+void exact_fit() {
+    int a = 1, b = 2, c = 3;
+    auto f =
+        make_function<int(int)>([a, b, c](int x) { return a + b + c + x; });
+    static_assert(sizeof(f) == 2 * sizeof(void*) + 16, "");
+    CHECK(f(1) == 7);
+    function<int(int)> wide = f;
+    CHECK(wide(0) == 6 && f(0) == 6);
+
+    auto u =
+        make_function<int()>([p = std::make_unique<int>(7)] { return *p; });
+    static_assert(!std::is_copy_constructible<decltype(u)>::value, "");
+    function<int(), fn_opt::move> m = std::move(u);
+    CHECK(m() == 7);
+}
+
+struct throwing_move {
+    std::string s = std::string(40, 't');
+    long pad[4] = {};
+
+    throwing_move() = default;
+    throwing_move(const throwing_move&) = default;
+    throwing_move(throwing_move&& rhs) noexcept(false) : s(rhs.s) {
+    }
+
+    size_t operator()() const {
+        return s.size();
+    }
+};
+
+void exact_fit_heap() {
+    // Targets with throwing move are allocated: only the pointer is local.
+    auto f = make_function<size_t() const>(throwing_move());
+    static_assert(sizeof(f) == 3 * sizeof(void*), "");
+    auto g = f;
+    CHECK(f() == 40 && g() == 40);
+}
+
+void cache_line() {
+    static_assert(sizeof(cl_function<void()>) == 64, "");
+    static_assert(sizeof(cl_function<void(), 2>) == 128, "");
+    static_assert(
+        sizeof(cl_function<int(int), 1, fn_opt::copy_move | fn_opt::batch>) ==
+            64,
+        "");
+    std::vector<cl_function<void()>> v(4);
+    CHECK(reinterpret_cast<uintptr_t>(v.data()) % 64 == 0);
+    long count = 0;
+    v[1] = [&count] { ++count; };
+    v[1]();
+    CHECK(count == 1);
+}
+
+void batch() {
+    using batch_function =
+        function<float(float), fn_opt::copy_move | fn_opt::batch>;
+    batch_function f = [](float x) { return x * 2 + 1; };
+    std::vector<float> in(100), out(100);
+    for(size_t i = 0; i < in.size(); ++i)
+        in[i] = static_cast<float>(i);
+    f.invoke_batch(in.data(), out.data(), in.size());
+    CHECK(out[10] == 21 && out[99] == 199);
+    CHECK(f(2) == 5);
+
+    std::vector<float> half(50);
+    f.invoke_batch(in.data(), 40, half.data(), half.size());
+    CHECK(half[39] == 79);
+    CHECK_THROWS(
+        f.invoke_batch(in.data(), in.size(), half.data(), half.size()),
+        std::length_error);
+#if defined(__cpp_lib_span)
+    f.invoke_batch(std::span<const float>(in), std::span<float>(out));
+    CHECK(out[3] == 7);
+    CHECK_THROWS(
+        f.invoke_batch(std::span<const float>(in), std::span<float>(half)),
+        std::length_error);
+#endif
+
+    batch_function g = std::move(f);
+    CHECK_THROWS(
+        f.invoke_batch(in.data(), out.data(), 1), std::bad_function_call);
+    function<float(float)> wide = g;
+    CHECK(wide(1) == 3);
+    static_assert(
+        !std::is_constructible<batch_function, decltype(wide)>::value, "");
+
+    // Batch output pointers do not break reference results.
+    function<int&(int&)> self = [](int& v) -> int& { return v; };
+    int v = 1;
+    self(v) = 2;
+    CHECK(v == 2);
+}
+
+#if UNIVANG_HAS_FUNCTION_CONSTEXPR
+constinit function<int(int)> constant_table[] = {
+    [](int x) { return x + 1; }, &twice, nullptr};
+#endif
+
+void constant() {
+#if UNIVANG_HAS_FUNCTION_CONSTEXPR
+    CHECK(constant_table[0](1) == 2 && constant_table[1](3) == 6);
+    CHECK(!constant_table[2]);
+#endif
+    function<int(int)> f = &twice;
+    CHECK(f(2) == 4);
+}
+
+struct named {
+    std::string name;
+
+    bool operator==(const named& rhs) const {
+        return name == rhs.name;
+    }
+    void operator()(int) const {
+    }
+};
+
+struct padded {
+    char c;
+    long v;
+
+    void operator()(int) const {
+    }
+};
+
+void comparable() {
+    using function_type =
+        function<void(int), fn_opt::copy_move | fn_opt::comparable>;
+    int x = 1, y = 2;
+    auto l = [x](int) { (void)x; };
+    function_type a = l, b = l, c = [y](int) { (void)y; };
+    CHECK(a == b && a != c);
+    function_type e1, e2;
+    CHECK(e1 == e2 && e1 != a);
+    function_type p = &notify, q = &notify, r = &notify_other;
+    CHECK(p == q && p != r);
+#if defined(__cpp_lib_has_unique_object_representations)
+    // Function pointers hash by value, not all into one bucket.
+    std::hash<function_type> hash;
+    CHECK(hash(p) == hash(q) && hash(p) != hash(r));
+#endif
+    function_type n1 = named{"a"}, n2 = named{"a"}, n3 = named{"b"};
+    CHECK(n1 == n2 && n1 != n3);
+    std::unordered_set<function_type> set{a, b, c, n1, n2, n3, e1};
+    CHECK(set.size() == 5);
+
+    // Padding bytes and floats are not the value: no bytewise fallback.
+    float f = 0;
+    auto by_float = [f](int) { (void)f; };
+    static_assert(
+        !detail::function::is_comparable_target<padded>::value, "padding");
+    static_assert(
+        !detail::function::is_comparable_target<decltype(by_float)>::value,
+        "float");
+    int* px = &x;
+    function_type by_pointer = [px](int) { (void)px; };
+    CHECK(by_pointer == function_type(by_pointer));
+}
+
+void c_callback() {
+    int base = 10;
+    function<int(int)> f = [base](int v) { return base * v; };
+    auto cb = f.c_callback();
+    CHECK(cb.fn(cb.context, 3) == 30);
+
+    int k = 5;
+    function<int(int)> a(&plus_context, &k);
+    CHECK(a(1) == 6);
+    CHECK(a.c_callback().fn == &plus_context && a.c_callback().context == &k);
+
+    function<int(int)> n(nullptr, &k);
+    CHECK(!n && n.c_callback().fn == nullptr);
+}
+
+struct handler {
+    virtual ~handler() = default;
+    virtual int operator()(int v) = 0;
+};
+
+struct add_handler : handler {
+    int k;
+
+    explicit add_handler(int k) : k(k) {
+    }
+    int operator()(int v) override {
+        return v + k;
+    }
+};
+
+void adopt() {
+    function<int(int), fn_opt::move> f =
+        std::unique_ptr<handler>(new add_handler(3));
+    CHECK(f(1) == 4);
+
+    std::shared_ptr<handler> sp = std::make_shared<add_handler>(7);
+    function<int(int)> s1 = sp, s2 = s1;
+    CHECK(s1(0) == 7 && s2(1) == 8 && sp.use_count() == 3);
+
+    function<int(int), fn_opt::move> e = std::unique_ptr<handler>();
+    CHECK(!e);
+}
+
+} // namespace
+
+int main() {
+    relocatable();
+    exact_fit();
+    exact_fit_heap();
+    cache_line();
+    batch();
+    constant();
+    comparable();
+    c_callback();
+    adopt();
+    return univang::test::result("function");
+}
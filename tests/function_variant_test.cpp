@@ -0,0 +1,69 @@
+// variant_function: closed set targets.
+//============================================================================
+#include "check.hpp"
+
+#include <univang/function_variant.hpp>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+
+using namespace univang;
+
+namespace {
+
+void closed_set() {
+    int k = 2;
+    std::string s(50, 'q');
+    auto idle = [](int e) { return e; };
+    auto busy = [k](int e) { return e * k; };
+    auto str = [s](int e) {
+        return e + static_cast<int>(std::count(s.begin(), s.end(), 'q'));
+    };
+    using state = variant_function<
+        int(int), decltype(idle), decltype(busy), decltype(str)>;
+
+    state v;
+    CHECK(!v && v.index() == 3);
+    CHECK_THROWS(v(1), std::bad_function_call);
+    v = idle;
+    CHECK(v(3) == 3 && v.index() == 0);
+    v = busy;
+    CHECK(v(3) == 6 && v.holds<decltype(busy)>());
+    v = str;
+    CHECK(v(1) == 51);
+    v = *v.target<decltype(str)>();
+    v.emplace<decltype(str)>(*v.target<decltype(str)>());
+    CHECK(v(1) == 51);
+
+    state w = v;
+    state x = std::move(w);
+    CHECK(x(0) == 50 && !w);
+    w = idle;
+    swap(w, x);
+    CHECK(w(0) == 50 && x(7) == 7);
+    CHECK(x.target<decltype(idle)>() != nullptr);
+    CHECK(x.target<decltype(busy)>() == nullptr);
+    v = nullptr;
+    CHECK(v == nullptr);
+}
+
+void move_only() {
+    auto idle = [](int e) { return e; };
+    auto owned = [p = std::make_unique<int>(4)](int e) { return e + *p; };
+    variant_function<int(int), decltype(idle), decltype(owned)> m =
+        std::move(owned);
+    static_assert(!std::is_copy_constructible<decltype(m)>::value, "");
+    auto moved = std::move(m);
+    CHECK(moved(1) == 5);
+    moved.emplace<decltype(idle)>(idle);
+    CHECK(moved(9) == 9);
+}
+
+} // namespace
+
+int main() {
+    closed_set();
+    move_only();
+    return univang::test::result("function_variant");
+}
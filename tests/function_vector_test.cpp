@@ -0,0 +1,58 @@
+// function_vector: growth by relocation, copies and erase.
+//============================================================================
+#include "check.hpp"
+
+#include <univang/function_vector.hpp>
+
+#include <string>
+
+using namespace univang;
+
+namespace {
+
+using relocatable_function =
+    function<int(int), fn_opt::copy_move | fn_opt::relocatable>;
+
+void relocatable_growth() {
+    function_vector<relocatable_function> v;
+    std::string s = "hello";
+    long expected = 0;
+    for(int i = 0; i < 1000; ++i) {
+        if(i % 2 != 0) {
+            v.push_back([i](int x) { return x + i; });
+            expected += 1 + i;
+        } else {
+            v.emplace_back(
+                [s, i](int x) { return x + i + static_cast<int>(s.size()); });
+            expected += 1 + i + 5;
+        }
+    }
+    long sum = 0;
+    for(auto& f : v)
+        sum += f(1);
+    CHECK(sum == expected && v.size() == 1000);
+
+    v.erase(v.begin() + 3);
+    CHECK(v.size() == 999 && v[3](0) == 4 + 5);
+}
+
+void copies() {
+    function_vector<function<int(int)>> w;
+    std::string s(50, 's');
+    for(int i = 0; i < 100; ++i)
+        w.emplace_back([s, i](int x) { return x + i; });
+    auto copy = w;
+    w.erase(w.begin());
+    CHECK(copy.size() == 100 && copy[0](0) == 0);
+    CHECK(w.size() == 99 && w[0](0) == 1);
+    auto moved = std::move(copy);
+    CHECK(copy.empty() && moved[99](1) == 100);
+}
+
+} // namespace
+
+int main() {
+    relocatable_growth();
+    copies();
+    return univang::test::result("function_vector");
+}
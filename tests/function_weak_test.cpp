@@ -0,0 +1,81 @@
+// weak_function: calls skipped after the owner is released.
+//============================================================================
+#include "check.hpp"
+
+#include <univang/function_weak.hpp>
+
+#include <string>
+#include <vector>
+
+using namespace univang;
+
+namespace {
+
+struct view {
+    int n = 0;
+
+    void update(int v) {
+        n += v;
+    }
+    int get(int k) const {
+        return n * k;
+    }
+    int& count() {
+        return n;
+    }
+};
+
+void subscribers() {
+    auto a = std::make_shared<view>(), b = std::make_shared<view>();
+    std::vector<weak_function<void(int)>> subs;
+    subs.push_back(bind_weak(std::weak_ptr<view>(a), &view::update));
+    subs.push_back(bind_weak(std::weak_ptr<view>(b), &view::update));
+    int captured = 0;
+    subs.emplace_back(
+        std::weak_ptr<view>(a), [&captured](int v) { captured += v; });
+    for(auto& s : subs)
+        s(2);
+    for(auto& s : subs)
+        s.invoke_unlocked(1);
+    CHECK(a->n == 3 && b->n == 3 && captured == 3);
+    static_assert(sizeof(subs[0]) <= 64, "one cache line");
+
+    b.reset();
+    CHECK(subs[1].expired() && !subs[1]);
+    subs[1](5);
+    CHECK(erase_expired(subs) == 1 && subs.size() == 2);
+
+    auto g = bind_weak(std::weak_ptr<view>(a), &view::get);
+    CHECK(g(2) == 6);
+    a.reset();
+    CHECK(g(2) == 0);
+
+    // Captures beyond the member pointer size are allocated.
+    auto c = std::make_shared<view>();
+    std::string tag(40, 't');
+    weak_function<size_t(int)> big(
+        std::weak_ptr<view>(c), [tag](int k) { return tag.size() * k; });
+    CHECK(big(2) == 80);
+    c.reset();
+    CHECK(big(2) == 0);
+
+    // Expired calls cannot produce a reference.
+    auto d = std::make_shared<view>();
+    auto r = bind_weak(std::weak_ptr<view>(d), &view::count);
+    r() = 4;
+    CHECK(d->n == 4);
+    d.reset();
+    CHECK_THROWS(r(), std::bad_function_call);
+    CHECK_THROWS(r.invoke_unlocked(), std::bad_function_call);
+
+    weak_function<void(int)> e;
+    e(1);
+    CHECK(e.expired());
+}
+
+} // namespace
+
+int main() {
+    subscribers();
+    return univang::test::result("function_weak");
+}